@@ -23,9 +23,16 @@ INCLUDEPATH += . $$SRC/contrib
 HEADERS +=  \
     $$SRC/aboutdlg.hpp \
     $$SRC/application.hpp \
+    $$SRC/binarymapview.hpp \
+    $$SRC/binaryserializer.hpp \
+    $$SRC/changejournal.hpp \
+    $$SRC/compresseddevice.hpp \
     $$SRC/config.hpp \
+    $$SRC/contenthash.hpp \
     $$SRC/draganddropstore.hpp \
     $$SRC/graph.hpp \
+    $$SRC/graphobserver.hpp \
+    $$SRC/graphsnapshot.hpp \
     $$SRC/graphicsfactory.hpp \
     $$SRC/edge.hpp \
     $$SRC/edgebase.hpp \
@@ -39,12 +46,15 @@ HEADERS +=  \
     $$SRC/hashseed.hpp \
     $$SRC/layers.hpp \
     $$SRC/mainwindow.hpp \
+    $$SRC/mapcache.hpp \
     $$SRC/mediator.hpp \
     $$SRC/mindmapdata.hpp \
     $$SRC/mindmapdatabase.hpp \
+    $$SRC/mindmaploader.hpp \
     $$SRC/node.hpp \
     $$SRC/nodebase.hpp \
     $$SRC/nodehandle.hpp \
+    $$SRC/nodestore.hpp \
     $$SRC/reader.hpp \
     $$SRC/serializer.hpp \
     $$SRC/statemachine.hpp \
@@ -56,8 +66,14 @@ HEADERS +=  \
 SOURCES += \
     $$SRC/aboutdlg.cpp \
     $$SRC/application.cpp \
+    $$SRC/binarymapview.cpp \
+    $$SRC/binaryserializer.cpp \
+    $$SRC/changejournal.cpp \
+    $$SRC/compresseddevice.cpp \
+    $$SRC/contenthash.cpp \
     $$SRC/draganddropstore.cpp \
     $$SRC/graph.cpp \
+    $$SRC/graphsnapshot.cpp \
     $$SRC/graphicsfactory.cpp \
     $$SRC/edge.cpp \
     $$SRC/edgebase.cpp \
@@ -70,12 +86,15 @@ SOURCES += \
     $$SRC/hashseed.cpp \
     $$SRC/main.cpp \
     $$SRC/mainwindow.cpp \
+    $$SRC/mapcache.cpp \
     $$SRC/mediator.cpp \
     $$SRC/mindmapdata.cpp \
     $$SRC/mindmapdatabase.cpp \
+    $$SRC/mindmaploader.cpp \
     $$SRC/node.cpp \
     $$SRC/nodebase.cpp \
     $$SRC/nodehandle.cpp \
+    $$SRC/nodestore.cpp \
     $$SRC/reader.cpp \
     $$SRC/serializer.cpp \
     $$SRC/statemachine.cpp \
@@ -0,0 +1,212 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "binarymapview.hpp"
+
+#include <QtEndian>
+
+#include <cassert>
+#include <cstring>
+
+namespace {
+
+template<typename T>
+T readValue(const uchar * data)
+{
+    return qFromLittleEndian<T>(data);
+}
+
+double readDouble(const uchar * data)
+{
+    const auto bits = qFromLittleEndian<quint64>(data);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+constexpr const char * BinaryMapView::MAGIC;
+
+constexpr quint32 BinaryMapView::VERSION;
+
+constexpr qint64 BinaryMapView::HEADER_SIZE;
+
+constexpr qint64 BinaryMapView::NODE_RECORD_SIZE;
+
+constexpr qint64 BinaryMapView::EDGE_RECORD_SIZE;
+
+BinaryMapView::BinaryMapView(const uchar * data, qint64 size)
+    : m_data(data)
+    , m_size(size)
+{
+    if (hasMagic(data, size) && size >= HEADER_SIZE && version() == VERSION)
+    {
+        const qint64 requiredSize = HEADER_SIZE +
+            NODE_RECORD_SIZE * readValue<quint32>(m_data + 8) +
+            EDGE_RECORD_SIZE * readValue<quint32>(m_data + 12) +
+            2 * static_cast<qint64>(readValue<quint32>(m_data + 16));
+        m_isValid = size >= requiredSize;
+    }
+}
+
+bool BinaryMapView::isValid() const
+{
+    return m_isValid;
+}
+
+bool BinaryMapView::hasMagic(const uchar * data, qint64 size)
+{
+    return data && size >= 4 && !std::memcmp(data, MAGIC, 4);
+}
+
+quint32 BinaryMapView::version() const
+{
+    return readValue<quint32>(m_data + 4);
+}
+
+QString BinaryMapView::applicationVersion() const
+{
+    return string(m_data + 24);
+}
+
+QColor BinaryMapView::backgroundColor() const
+{
+    return QColor::fromRgba(readValue<quint32>(m_data + 20));
+}
+
+int BinaryMapView::numNodes() const
+{
+    return static_cast<int>(readValue<quint32>(m_data + 8));
+}
+
+int BinaryMapView::numEdges() const
+{
+    return static_cast<int>(readValue<quint32>(m_data + 12));
+}
+
+int BinaryMapView::numStringUnits() const
+{
+    return static_cast<int>(readValue<quint32>(m_data + 16));
+}
+
+int BinaryMapView::nodeIndex(int record) const
+{
+    return readValue<qint32>(nodeRecord(record));
+}
+
+QColor BinaryMapView::nodeColor(int record) const
+{
+    return QColor::fromRgba(readValue<quint32>(nodeRecord(record) + 4));
+}
+
+QPointF BinaryMapView::nodeLocation(int record) const
+{
+    return {readDouble(nodeRecord(record) + 8), readDouble(nodeRecord(record) + 16)};
+}
+
+QSizeF BinaryMapView::nodeSize(int record) const
+{
+    return {readDouble(nodeRecord(record) + 24), readDouble(nodeRecord(record) + 32)};
+}
+
+QString BinaryMapView::nodeText(int record) const
+{
+    return string(nodeRecord(record) + 40);
+}
+
+int BinaryMapView::edgeIndex0(int record) const
+{
+    return readValue<qint32>(edgeRecord(record));
+}
+
+int BinaryMapView::edgeIndex1(int record) const
+{
+    return readValue<qint32>(edgeRecord(record) + 4);
+}
+
+QString BinaryMapView::edgeText(int record) const
+{
+    return string(edgeRecord(record) + 8);
+}
+
+bool BinaryMapView::hasValidTexts() const
+{
+    if (!isValidString(m_data + 24))
+    {
+        return false;
+    }
+
+    for (int record = 0; record < numNodes(); record++)
+    {
+        if (!isValidString(nodeRecord(record) + 40))
+        {
+            return false;
+        }
+    }
+
+    for (int record = 0; record < numEdges(); record++)
+    {
+        if (!isValidString(edgeRecord(record) + 8))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const uchar * BinaryMapView::nodeRecord(int record) const
+{
+    assert(record >= 0 && record < numNodes());
+    return m_data + HEADER_SIZE + NODE_RECORD_SIZE * record;
+}
+
+const uchar * BinaryMapView::edgeRecord(int record) const
+{
+    assert(record >= 0 && record < numEdges());
+    return m_data + HEADER_SIZE + NODE_RECORD_SIZE * numNodes() + EDGE_RECORD_SIZE * record;
+}
+
+bool BinaryMapView::isValidString(const uchar * reference) const
+{
+    const qint64 offset = readValue<quint32>(reference);
+    const qint64 length = readValue<quint32>(reference + 4);
+    return offset + length <= numStringUnits();
+}
+
+QString BinaryMapView::string(const uchar * reference) const
+{
+    const auto offset = readValue<quint32>(reference);
+    const auto length = static_cast<int>(readValue<quint32>(reference + 4));
+    const auto strings = m_data + HEADER_SIZE + NODE_RECORD_SIZE * numNodes() + EDGE_RECORD_SIZE * numEdges();
+    const auto units = strings + 2 * static_cast<qint64>(offset);
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // The units can be used as they are, but QChar wants an aligned address
+    if (!(reinterpret_cast<quintptr>(units) % alignof(QChar)))
+    {
+        return QString(reinterpret_cast<const QChar *>(units), length);
+    }
+#endif
+
+    QString result(length, Qt::Uninitialized);
+    for (int i = 0; i < length; i++)
+    {
+        result[i] = QChar(readValue<quint16>(units + 2 * i));
+    }
+    return result;
+}
@@ -0,0 +1,110 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef BINARYMAPVIEW_HPP
+#define BINARYMAPVIEW_HPP
+
+#include <QColor>
+#include <QPointF>
+#include <QSizeF>
+#include <QString>
+
+/*! Read-only view to a mind map in the binary format, typically a file mapped with QFile::map().
+ *
+ *  The data is never parsed up front: the accessors decode fields straight from the fixed-width
+ *  records, so only the records actually touched cost anything. All values are little-endian.
+ *
+ *  Layout:
+ *  - Header (HEADER_SIZE bytes): magic, format version, node count, edge count,
+ *    string table length in UTF-16 code units, background color as 0xAARRGGBB,
+ *    application version string offset and length.
+ *  - Node records (NODE_RECORD_SIZE bytes each): index, color as 0xAARRGGBB,
+ *    x, y, width and height as doubles, text offset and length.
+ *  - Edge records (EDGE_RECORD_SIZE bytes each): source index, target index, text offset and length.
+ *  - String table: UTF-16 code units. Offsets and lengths of texts are given in code units.
+ *
+ *  The view doesn't own the data, which must stay valid for the lifetime of the view. */
+class BinaryMapView
+{
+public:
+
+    static constexpr auto MAGIC = "HMRB";
+
+    static constexpr quint32 VERSION = 1;
+
+    static constexpr qint64 HEADER_SIZE = 32;
+
+    static constexpr qint64 NODE_RECORD_SIZE = 48;
+
+    static constexpr qint64 EDGE_RECORD_SIZE = 16;
+
+    BinaryMapView(const uchar * data, qint64 size);
+
+    //! \return true if the data has a known magic and version and is large enough for all the tables.
+    bool isValid() const;
+
+    //! \return true if the data starts with the magic of the binary format.
+    static bool hasMagic(const uchar * data, qint64 size);
+
+    quint32 version() const;
+
+    QString applicationVersion() const;
+
+    QColor backgroundColor() const;
+
+    int numNodes() const;
+
+    int numEdges() const;
+
+    int numStringUnits() const;
+
+    int nodeIndex(int record) const;
+
+    QColor nodeColor(int record) const;
+
+    QPointF nodeLocation(int record) const;
+
+    QSizeF nodeSize(int record) const;
+
+    QString nodeText(int record) const;
+
+    int edgeIndex0(int record) const;
+
+    int edgeIndex1(int record) const;
+
+    QString edgeText(int record) const;
+
+    //! \return true if all text references point inside the string table.
+    bool hasValidTexts() const;
+
+private:
+
+    const uchar * nodeRecord(int record) const;
+
+    const uchar * edgeRecord(int record) const;
+
+    bool isValidString(const uchar * reference) const;
+
+    QString string(const uchar * reference) const;
+
+    const uchar * m_data;
+
+    qint64 m_size;
+
+    bool m_isValid = false;
+};
+
+#endif // BINARYMAPVIEW_HPP
@@ -0,0 +1,241 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "binaryserializer.hpp"
+#include "binarymapview.hpp"
+#include "config.hpp"
+#include "edgebase.hpp"
+#include "graph.hpp"
+#include "graphsnapshot.hpp"
+#include "nodebase.hpp"
+#include "mclogger.hh"
+
+#include <QDataStream>
+#include <QFile>
+#include <QIODevice>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using std::make_shared;
+
+namespace {
+
+//! Smallest number of node records worth a task of its own.
+const int MIN_RECORDS_PER_TASK = 1024;
+
+//! Decodes a range of node records into detached NodeBase objects.
+class NodeDecoder : public QRunnable
+{
+public:
+
+    NodeDecoder(const BinaryMapView & view, Graph::NodeVector & nodes, int begin, int end)
+        : m_view(view)
+        , m_nodes(nodes)
+        , m_begin(begin)
+        , m_end(end)
+    {
+    }
+
+    virtual void run() override
+    {
+        // Each task writes only to its own range of the preallocated vector
+        for (int record = m_begin; record < m_end; record++)
+        {
+            auto node = make_shared<NodeBase>();
+            node->setIndex(m_view.nodeIndex(record));
+            node->setLocation(m_view.nodeLocation(record));
+            node->setSize(m_view.nodeSize(record));
+            node->setColor(m_view.nodeColor(record));
+            node->setText(m_view.nodeText(record));
+            m_nodes[record] = node;
+        }
+    }
+
+private:
+
+    const BinaryMapView & m_view;
+
+    Graph::NodeVector & m_nodes;
+
+    const int m_begin;
+
+    const int m_end;
+};
+
+//! Decodes all node records in parallel chunks.
+Graph::NodeVector decodeNodes(const BinaryMapView & view)
+{
+    Graph::NodeVector nodes(view.numNodes());
+
+    QThreadPool pool;
+    const int numTasks = std::max(1, pool.maxThreadCount());
+    const int recordsPerTask = std::max(MIN_RECORDS_PER_TASK, (view.numNodes() + numTasks - 1) / numTasks);
+    for (int begin = 0; begin < view.numNodes(); begin += recordsPerTask)
+    {
+        pool.start(new NodeDecoder(view, nodes, begin, std::min(begin + recordsPerTask, view.numNodes())));
+    }
+
+    pool.waitForDone();
+
+    return nodes;
+}
+
+} // namespace
+
+MindMapDataPtr BinarySerializer::fromBinary(const BinaryMapView & view)
+{
+    if (!view.isValid() || !view.hasValidTexts())
+    {
+        MCLogger().error() << "Invalid binary map";
+        return MindMapDataPtr();
+    }
+
+    auto data = make_shared<MindMapData>();
+    data->setVersion(view.applicationVersion());
+    data->setBackgroundColor(view.backgroundColor());
+
+    const auto nodes = decodeNodes(view);
+
+    std::unordered_map<int, NodeBasePtr> nodesByIndex;
+    nodesByIndex.reserve(nodes.size());
+    for (auto && node : nodes)
+    {
+        nodesByIndex.emplace(node->index(), node);
+    }
+
+    Graph::EdgeVector edges;
+    edges.reserve(view.numEdges());
+    for (int record = 0; record < view.numEdges(); record++)
+    {
+        const auto iter0 = nodesByIndex.find(view.edgeIndex0(record));
+        const auto iter1 = nodesByIndex.find(view.edgeIndex1(record));
+        if (iter0 == nodesByIndex.end() || iter1 == nodesByIndex.end())
+        {
+            MCLogger().error() << "Invalid edge " << view.edgeIndex0(record) << " -> " << view.edgeIndex1(record);
+            return MindMapDataPtr();
+        }
+
+        auto edge = make_shared<EdgeBase>(*iter0->second, *iter1->second);
+        edge->setText(view.edgeText(record));
+        edges.push_back(edge);
+    }
+
+    data->graph().build(nodes, edges);
+
+    return data;
+}
+
+MindMapDataPtr BinarySerializer::fromBinary(QFile & file, qint64 offset)
+{
+    // Map the file so that only the pages actually touched get read
+    if (const auto mapped = file.map(offset, file.size() - offset))
+    {
+        const auto data = fromBinary(BinaryMapView(mapped, file.size() - offset));
+        file.unmap(mapped);
+        return data;
+    }
+
+    // Not all file systems support mapping
+    file.seek(offset);
+    const auto bytes = file.readAll();
+    return fromBinary(BinaryMapView(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size()));
+}
+
+//! Writes either a live Graph or a GraphSnapshot, which have the same interface for this.
+template<typename Source>
+static bool writeBinary(const Source & source, QColor backgroundColor, QIODevice & device)
+{
+    // Collect the texts first as the records refer to the string table by offset
+    QString strings;
+    const auto addString = [&strings] (const QString & text) {
+        const auto reference = std::make_pair(static_cast<quint32>(strings.size()), static_cast<quint32>(text.size()));
+        strings += text;
+        return reference;
+    };
+
+    const auto applicationVersion = addString(Config::APPLICATION_VERSION);
+
+    std::vector<std::pair<quint32, quint32> > nodeTexts;
+    nodeTexts.reserve(source.numNodes());
+    source.forEachNode([&] (int, const QPointF &, const QSizeF &, const QColor &, const QString & text) {
+        nodeTexts.push_back(addString(text));
+    });
+
+    std::vector<std::pair<quint32, quint32> > edgeTexts;
+    edgeTexts.reserve(source.numEdges());
+    for (int position = 0; position < source.numNodes(); position++)
+    {
+        source.forEachEdgeFromPosition(position, [&] (int, const QString & text) {
+            edgeTexts.push_back(addString(text));
+        });
+    }
+
+    QDataStream out(&device);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+    out.writeRawData(BinaryMapView::MAGIC, 4);
+    out << BinaryMapView::VERSION
+        << static_cast<quint32>(source.numNodes())
+        << static_cast<quint32>(source.numEdges())
+        << static_cast<quint32>(strings.size())
+        << static_cast<quint32>(backgroundColor.rgba())
+        << applicationVersion.first << applicationVersion.second;
+
+    // Nodes are numbered by their position like in the XML format
+    source.forEachNode([&] (int position, const QPointF & location, const QSizeF & size, const QColor & color, const QString &) {
+        out << static_cast<qint32>(position)
+            << static_cast<quint32>(color.rgba())
+            << location.x() << location.y()
+            << size.width() << size.height()
+            << nodeTexts[position].first << nodeTexts[position].second;
+    });
+
+    // Edges are in the same order as in the XML format, i.e. grouped by source node
+    int edge = 0;
+    for (int position = 0; position < source.numNodes(); position++)
+    {
+        source.forEachEdgeFromPosition(position, [&] (int target, const QString &) {
+            out << static_cast<qint32>(position)
+                << static_cast<qint32>(target)
+                << edgeTexts[edge].first << edgeTexts[edge].second;
+            edge++;
+        });
+    }
+
+    for (auto && unit : strings)
+    {
+        out << static_cast<quint16>(unit.unicode());
+    }
+
+    return out.status() == QDataStream::Ok;
+}
+
+bool BinarySerializer::toBinary(MindMapData & mindMapData, QIODevice & device)
+{
+    // Write from the live graph so that nothing but the texts is copied
+    return writeBinary(mindMapData.graph(), mindMapData.backgroundColor(), device);
+}
+
+bool BinarySerializer::toBinary(const GraphSnapshot & snapshot, QColor backgroundColor, QIODevice & device)
+{
+    return writeBinary(snapshot, backgroundColor, device);
+}
@@ -0,0 +1,46 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef BINARYSERIALIZER_HPP
+#define BINARYSERIALIZER_HPP
+
+#include "mindmapdata.hpp"
+
+class BinaryMapView;
+class GraphSnapshot;
+class QFile;
+class QIODevice;
+
+//! Conversions between mind maps and the binary format described in BinaryMapView.
+namespace BinarySerializer {
+
+    /*! Decodes the node records in parallel on a thread pool and links the edges in a final pass.
+     *  The graph consists of plain NodeBase and EdgeBase objects, see Serializer::fromXml().
+     *  \return nullptr if the view is not valid or refers to missing texts or nodes. */
+    MindMapDataPtr fromBinary(const BinaryMapView & view);
+
+    //! Decodes the binary map that starts at the given offset of the open file.
+    MindMapDataPtr fromBinary(QFile & file, qint64 offset = 0);
+
+    //! Numbers the nodes densely like Serializer::toXml().
+    //! \return false if writing to the device failed.
+    bool toBinary(MindMapData & mindMapData, QIODevice & device);
+
+    //! Writes the design from a snapshot. Can be called from any thread.
+    bool toBinary(const GraphSnapshot & snapshot, QColor backgroundColor, QIODevice & device);
+}
+
+#endif // BINARYSERIALIZER_HPP
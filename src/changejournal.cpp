@@ -0,0 +1,393 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "changejournal.hpp"
+#include "edgebase.hpp"
+#include "graph.hpp"
+#include "nodebase.hpp"
+#include "mclogger.hh"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+
+using std::make_shared;
+
+constexpr const char * ChangeJournal::MAGIC;
+
+constexpr quint32 ChangeJournal::VERSION;
+
+constexpr qint64 ChangeJournal::MIN_COMPACTION_SIZE;
+
+enum class Record : quint8
+{
+    NodeAdded = 1,
+    NodeChanged,
+    NodeRemoved,
+    EdgeAdded,
+    EdgeChanged,
+    BackgroundColor
+};
+
+static void setUpStream(QDataStream & stream)
+{
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+}
+
+//! Identifies the version of the mind map file the journal applies to.
+static bool readBase(QString filePath, qint64 & size, qint64 & modified)
+{
+    const QFileInfo fileInfo(filePath);
+    if (!fileInfo.exists())
+    {
+        return false;
+    }
+
+    size = fileInfo.size();
+    modified = fileInfo.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+static bool applyBatch(const QByteArray & batch, MindMapData & mindMapData)
+{
+    QDataStream in(batch);
+    setUpStream(in);
+
+    auto & graph = mindMapData.graph();
+    while (!in.atEnd())
+    {
+        quint8 type = 0;
+        in >> type;
+        switch (static_cast<Record>(type))
+        {
+        case Record::NodeAdded:
+        case Record::NodeChanged:
+        {
+            qint32 index = -1;
+            double x = 0, y = 0, w = 0, h = 0;
+            quint32 color = 0;
+            QString text;
+            in >> index >> x >> y >> w >> h >> color >> text;
+
+            auto node = graph.getNode(index);
+            const bool isNew = !node;
+            if (isNew)
+            {
+                node = make_shared<NodeBase>();
+                node->setIndex(index);
+            }
+
+            node->setLocation(QPointF(x, y));
+            node->setSize(QSizeF(w, h));
+            node->setColor(QColor::fromRgba(color));
+            node->setText(text);
+
+            if (isNew)
+            {
+                graph.addNode(node);
+            }
+            break;
+        }
+        case Record::NodeRemoved:
+        {
+            qint32 index = -1;
+            in >> index;
+            graph.deleteNode(index);
+            break;
+        }
+        case Record::EdgeAdded:
+        case Record::EdgeChanged:
+        {
+            qint32 index0 = -1, index1 = -1;
+            QString text;
+            in >> index0 >> index1 >> text;
+
+            if (static_cast<Record>(type) == Record::EdgeChanged)
+            {
+                graph.forEachEdgeFromNode(index0, [&] (EdgeBase & edge) {
+                    if (edge.targetNodeBase().index() == index1)
+                    {
+                        edge.setText(text);
+                    }
+                });
+            }
+            else
+            {
+                const auto node0 = graph.getNode(index0);
+                const auto node1 = graph.getNode(index1);
+                if (node0 && node1)
+                {
+                    auto edge = make_shared<EdgeBase>(*node0, *node1);
+                    edge->setText(text);
+                    graph.addEdge(edge);
+                }
+            }
+            break;
+        }
+        case Record::BackgroundColor:
+        {
+            quint32 color = 0;
+            in >> color;
+            mindMapData.setBackgroundColor(QColor::fromRgba(color));
+            break;
+        }
+        default:
+            MCLogger().warning() << "Unknown journal record " << static_cast<int>(type);
+            return false;
+        }
+
+        if (in.status() != QDataStream::Ok)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+ChangeJournal::ChangeJournal(QString filePath)
+    : m_filePath(filePath)
+{
+}
+
+ChangeJournal::~ChangeJournal()
+{
+    stop();
+}
+
+QString ChangeJournal::journalFileName(QString filePath)
+{
+    return filePath + ".journal";
+}
+
+bool ChangeJournal::start(MindMapDataPtr mindMapData)
+{
+    stop();
+
+    qint64 baseModified = 0;
+    if (!readBase(m_filePath, m_baseSize, baseModified))
+    {
+        return false;
+    }
+
+    // Replaces the previous journal as it doesn't apply to the new file anymore
+    QSaveFile file(journalFileName(m_filePath));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    QDataStream out(&file);
+    setUpStream(out);
+    out.writeRawData(MAGIC, 4);
+    out << VERSION << m_baseSize << baseModified;
+    if (out.status() != QDataStream::Ok)
+    {
+        file.cancelWriting();
+    }
+
+    if (!file.commit())
+    {
+        return false;
+    }
+
+    m_mindMapData = mindMapData;
+    m_backgroundColor = mindMapData->backgroundColor();
+    m_mindMapData->graph().addObserver(*this);
+    return true;
+}
+
+void ChangeJournal::stop()
+{
+    if (m_mindMapData)
+    {
+        m_mindMapData->graph().removeObserver(*this);
+        m_mindMapData.reset();
+    }
+
+    m_pending.clear();
+    m_lastNodeChangePosition = -1;
+}
+
+bool ChangeJournal::isRecording(const MindMapData & mindMapData) const
+{
+    return m_mindMapData.get() == &mindMapData;
+}
+
+bool ChangeJournal::isFull() const
+{
+    return QFileInfo(journalFileName(m_filePath)).size() > std::max(MIN_COMPACTION_SIZE, m_baseSize / 2);
+}
+
+bool ChangeJournal::append()
+{
+    assert(m_mindMapData);
+
+    // The background color is not part of the graph so it's checked only here
+    if (m_mindMapData->backgroundColor() != m_backgroundColor)
+    {
+        m_backgroundColor = m_mindMapData->backgroundColor();
+
+        QDataStream out(&m_pending, QIODevice::Append);
+        setUpStream(out);
+        out << static_cast<quint8>(Record::BackgroundColor) << static_cast<quint32>(m_backgroundColor.rgba());
+        m_lastNodeChangePosition = -1;
+    }
+
+    if (m_pending.isEmpty())
+    {
+        return true;
+    }
+
+    QFile file(journalFileName(m_filePath));
+    if (!file.open(QIODevice::Append))
+    {
+        return false;
+    }
+
+    const auto batchPosition = file.size();
+
+    QDataStream out(&file);
+    setUpStream(out);
+    out << static_cast<quint32>(m_pending.size());
+    out.writeRawData(m_pending.constData(), m_pending.size());
+    if (out.status() != QDataStream::Ok || !file.flush())
+    {
+        // Don't leave a partial batch in front of the following ones
+        file.resize(batchPosition);
+        return false;
+    }
+
+    m_pending.clear();
+    m_lastNodeChangePosition = -1;
+    return true;
+}
+
+bool ChangeJournal::replay(QString filePath, MindMapData & mindMapData)
+{
+    QFile file(journalFileName(filePath));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream in(&file);
+    setUpStream(in);
+
+    char magic[4] = {};
+    quint32 version = 0;
+    qint64 baseSize = 0;
+    qint64 baseModified = 0;
+    in.readRawData(magic, 4);
+    in >> version >> baseSize >> baseModified;
+
+    qint64 size = 0;
+    qint64 modified = 0;
+    if (in.status() != QDataStream::Ok || std::memcmp(magic, MAGIC, 4) || version != VERSION ||
+        !readBase(filePath, size, modified) || size != baseSize || modified != baseModified)
+    {
+        MCLogger().warning() << "Ignoring journal '" << file.fileName().toStdString() << "' of another version of the file";
+        return false;
+    }
+
+    while (!in.atEnd())
+    {
+        quint32 length = 0;
+        in >> length;
+        QByteArray batch(static_cast<int>(std::min<quint32>(length, static_cast<quint32>(file.size()))), Qt::Uninitialized);
+        if (in.status() != QDataStream::Ok || in.readRawData(batch.data(), batch.size()) != static_cast<int>(length))
+        {
+            MCLogger().warning() << "Ignoring incomplete batch at the end of journal '" << file.fileName().toStdString() << "'";
+            break;
+        }
+
+        if (!applyBatch(batch, mindMapData))
+        {
+            MCLogger().warning() << "Corrupted batch in journal '" << file.fileName().toStdString() << "'";
+            break;
+        }
+    }
+
+    return true;
+}
+
+void ChangeJournal::nodeAdded(NodeBase & node)
+{
+    m_lastNodeChangePosition = -1;
+    writeNode(static_cast<quint8>(Record::NodeAdded), node);
+}
+
+void ChangeJournal::nodeRemoved(NodeBase & node)
+{
+    m_lastNodeChangePosition = -1;
+
+    QDataStream out(&m_pending, QIODevice::Append);
+    setUpStream(out);
+    out << static_cast<quint8>(Record::NodeRemoved) << static_cast<qint32>(node.index());
+}
+
+void ChangeJournal::nodeChanged(NodeBase & node)
+{
+    // Replace the previous change of the same node if nothing has happened in between
+    if (m_lastNodeChangePosition >= 0 && m_lastNodeChangeIndex == node.index())
+    {
+        m_pending.truncate(m_lastNodeChangePosition);
+    }
+
+    m_lastNodeChangePosition = m_pending.size();
+    m_lastNodeChangeIndex = node.index();
+    writeNode(static_cast<quint8>(Record::NodeChanged), node);
+}
+
+void ChangeJournal::edgeAdded(EdgeBase & edge)
+{
+    m_lastNodeChangePosition = -1;
+    writeEdge(static_cast<quint8>(Record::EdgeAdded), edge);
+}
+
+void ChangeJournal::edgeChanged(EdgeBase & edge)
+{
+    m_lastNodeChangePosition = -1;
+    writeEdge(static_cast<quint8>(Record::EdgeChanged), edge);
+}
+
+void ChangeJournal::writeNode(quint8 type, NodeBase & node)
+{
+    QDataStream out(&m_pending, QIODevice::Append);
+    setUpStream(out);
+    out << type << static_cast<qint32>(node.index())
+        << node.location().x() << node.location().y()
+        << node.size().width() << node.size().height()
+        << static_cast<quint32>(node.color().rgba())
+        << node.text();
+}
+
+void ChangeJournal::writeEdge(quint8 type, EdgeBase & edge)
+{
+    QDataStream out(&m_pending, QIODevice::Append);
+    setUpStream(out);
+    out << type << static_cast<qint32>(edge.sourceNodeBase().index())
+        << static_cast<qint32>(edge.targetNodeBase().index())
+        << edge.text();
+}
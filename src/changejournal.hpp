@@ -0,0 +1,111 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CHANGEJOURNAL_HPP
+#define CHANGEJOURNAL_HPP
+
+#include <QByteArray>
+#include <QColor>
+#include <QString>
+
+#include "graphobserver.hpp"
+#include "mindmapdata.hpp"
+
+/*! Append-only log of the changes made to a mind map since it was last written in full.
+ *
+ *  The journal lives next to the mind map file and starts with MAGIC, VERSION and the size and
+ *  modification time of the mind map file it applies to. It's followed by batches of a length and
+ *  the change records of one save. A batch cut short by a crash is ignored as a whole.
+ *
+ *  While recording, the journal observes the graph and collects the changes in memory. Consecutive
+ *  changes of the same node are coalesced, so e.g. dragging a node leaves a single record. Edges are
+ *  removed only together with their nodes, so the node records cover those. */
+class ChangeJournal : public GraphObserver
+{
+public:
+
+    static constexpr auto MAGIC = "HMRJ";
+
+    static constexpr quint32 VERSION = 1;
+
+    //! The journal is compacted into the mind map file when it grows past this or half the size of the mind map file.
+    static constexpr qint64 MIN_COMPACTION_SIZE = 64 * 1024;
+
+    //! \param filePath the mind map file the journal belongs to.
+    explicit ChangeJournal(QString filePath);
+
+    ChangeJournal(const ChangeJournal & other) = delete;
+
+    ChangeJournal & operator= (const ChangeJournal & other) = delete;
+
+    virtual ~ChangeJournal();
+
+    //! \return the journal file name of the given mind map file.
+    static QString journalFileName(QString filePath);
+
+    /*! Starts a new journal on top of a mind map file that has just been written in full
+     *  and starts recording the changes of the given mind map.
+     *  \return false if the journal file couldn't be written. */
+    bool start(MindMapDataPtr mindMapData);
+
+    //! \return true if the changes of the given mind map are being recorded.
+    bool isRecording(const MindMapData & mindMapData) const;
+
+    //! \return true if the journal should be compacted into the mind map file.
+    bool isFull() const;
+
+    //! Appends the changes recorded since the previous call as one batch. \return false on failure.
+    bool append();
+
+    //! Applies the journal of the given mind map file, if any, to the mind map read from that file.
+    //! Journals of other versions of the file are ignored. \return false if there was no valid journal.
+    static bool replay(QString filePath, MindMapData & mindMapData);
+
+    virtual void nodeAdded(NodeBase & node) override;
+
+    virtual void nodeRemoved(NodeBase & node) override;
+
+    virtual void nodeChanged(NodeBase & node) override;
+
+    virtual void edgeAdded(EdgeBase & edge) override;
+
+    virtual void edgeChanged(EdgeBase & edge) override;
+
+private:
+
+    void stop();
+
+    void writeNode(quint8 type, NodeBase & node);
+
+    void writeEdge(quint8 type, EdgeBase & edge);
+
+    const QString m_filePath;
+
+    MindMapDataPtr m_mindMapData;
+
+    QByteArray m_pending;
+
+    //! Position of the last record in m_pending so that it can be replaced by a newer change of the same node.
+    int m_lastNodeChangePosition = -1;
+
+    int m_lastNodeChangeIndex = -1;
+
+    QColor m_backgroundColor;
+
+    qint64 m_baseSize = 0;
+};
+
+#endif // CHANGEJOURNAL_HPP
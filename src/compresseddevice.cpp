@@ -0,0 +1,237 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "compresseddevice.hpp"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+constexpr const char * CompressedDevice::MAGIC;
+
+constexpr quint32 CompressedDevice::VERSION;
+
+constexpr int CompressedDevice::CHUNK_SIZE;
+
+constexpr quint32 CompressedDevice::MAX_CHUNK_SIZE;
+
+static QByteArray littleEndian(quint32 value)
+{
+    QByteArray bytes(sizeof(value), Qt::Uninitialized);
+    qToLittleEndian(value, reinterpret_cast<uchar *>(bytes.data()));
+    return bytes;
+}
+
+static quint32 fromLittleEndian(const QByteArray & bytes)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(bytes.constData()));
+}
+
+CompressedDevice::CompressedDevice(QIODevice & device)
+    : m_device(device)
+{
+}
+
+CompressedDevice::~CompressedDevice()
+{
+    close();
+}
+
+bool CompressedDevice::hasMagic(const QByteArray & data)
+{
+    return data.startsWith(MAGIC);
+}
+
+bool CompressedDevice::open(OpenMode mode)
+{
+    m_buffer.clear();
+    m_bufferPosition = 0;
+    m_atEnd = false;
+    m_failed = false;
+
+    if (mode == QIODevice::ReadOnly)
+    {
+        const auto header = m_device.read(8);
+        if (header.size() != 8 || !hasMagic(header))
+        {
+            return fail("Not a compressed stream");
+        }
+
+        if (fromLittleEndian(header.mid(4)) != VERSION)
+        {
+            return fail("Unsupported compressed stream version");
+        }
+    }
+    else if (mode == QIODevice::WriteOnly)
+    {
+        if (m_device.write(MAGIC, 4) != 4 || m_device.write(littleEndian(VERSION)) != 4)
+        {
+            return fail("Cannot write header: " + m_device.errorString());
+        }
+    }
+    else
+    {
+        return fail("Unsupported open mode");
+    }
+
+    return QIODevice::open(mode);
+}
+
+void CompressedDevice::close()
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    if (isWritable() && !m_failed)
+    {
+        if (!m_buffer.isEmpty())
+        {
+            writeChunk(m_buffer);
+            m_buffer.clear();
+        }
+
+        // The empty chunk tells the reader that the stream is complete
+        writeChunk(QByteArray());
+    }
+
+    QIODevice::close();
+}
+
+bool CompressedDevice::isSequential() const
+{
+    return true;
+}
+
+bool CompressedDevice::atEnd() const
+{
+    return QIODevice::bytesAvailable() == 0 && m_bufferPosition == m_buffer.size() && (m_atEnd || m_failed);
+}
+
+qint64 CompressedDevice::bytesAvailable() const
+{
+    return QIODevice::bytesAvailable() + m_buffer.size() - m_bufferPosition;
+}
+
+qint64 CompressedDevice::readData(char * data, qint64 maxSize)
+{
+    qint64 total = 0;
+    while (total < maxSize)
+    {
+        if (m_bufferPosition == m_buffer.size())
+        {
+            if (m_atEnd || m_failed || !readChunk())
+            {
+                break;
+            }
+        }
+
+        const auto count = std::min<qint64>(maxSize - total, m_buffer.size() - m_bufferPosition);
+        std::memcpy(data + total, m_buffer.constData() + m_bufferPosition, count);
+        m_bufferPosition += count;
+        total += count;
+    }
+
+    return total || !m_failed ? total : -1;
+}
+
+qint64 CompressedDevice::writeData(const char * data, qint64 size)
+{
+    if (m_failed)
+    {
+        return -1;
+    }
+
+    m_buffer.append(data, size);
+
+    // Large writes are split so that no chunk exceeds CHUNK_SIZE
+    int position = 0;
+    while (m_buffer.size() - position >= CHUNK_SIZE)
+    {
+        if (!writeChunk(QByteArray::fromRawData(m_buffer.constData() + position, CHUNK_SIZE)))
+        {
+            return -1;
+        }
+
+        position += CHUNK_SIZE;
+    }
+
+    m_buffer.remove(0, position);
+
+    return size;
+}
+
+bool CompressedDevice::readChunk()
+{
+    const auto sizeBytes = m_device.read(4);
+    if (sizeBytes.size() != 4)
+    {
+        return fail("Unexpected end of compressed stream");
+    }
+
+    const auto size = fromLittleEndian(sizeBytes);
+    if (!size)
+    {
+        m_atEnd = true;
+        return false;
+    }
+
+    if (size > MAX_CHUNK_SIZE)
+    {
+        return fail("Corrupted compressed stream");
+    }
+
+    const auto chunk = m_device.read(size);
+    if (chunk.size() != static_cast<int>(size))
+    {
+        return fail("Unexpected end of compressed stream");
+    }
+
+    // qCompress() output starts with the big-endian uncompressed size that qUncompress() would allocate
+    if (size < 4 || qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(chunk.constData())) > static_cast<quint32>(CHUNK_SIZE))
+    {
+        return fail("Corrupted compressed stream");
+    }
+
+    m_buffer = qUncompress(chunk);
+    m_bufferPosition = 0;
+    if (m_buffer.isEmpty())
+    {
+        return fail("Corrupted compressed stream");
+    }
+
+    return true;
+}
+
+bool CompressedDevice::writeChunk(const QByteArray & chunk)
+{
+    const auto compressed = chunk.isEmpty() ? QByteArray() : qCompress(chunk);
+    if (m_device.write(littleEndian(compressed.size())) != 4 || m_device.write(compressed) != compressed.size())
+    {
+        return fail("Cannot write compressed stream: " + m_device.errorString());
+    }
+
+    return true;
+}
+
+bool CompressedDevice::fail(QString message)
+{
+    m_failed = true;
+    setErrorString(message);
+    return false;
+}
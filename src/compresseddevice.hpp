@@ -0,0 +1,89 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef COMPRESSEDDEVICE_HPP
+#define COMPRESSEDDEVICE_HPP
+
+#include <QByteArray>
+#include <QIODevice>
+
+/*! Sequential device that compresses to or decompresses from another device on the fly.
+ *
+ *  The stream starts with a header of MAGIC and a little-endian VERSION. It's followed by chunks of
+ *  a little-endian compressed size and qCompress() output of at most CHUNK_SIZE bytes, and terminated
+ *  by a chunk of size 0. Only one chunk is held in memory at a time.
+ *
+ *  The underlying device must be open and outlive this object. */
+class CompressedDevice : public QIODevice
+{
+public:
+
+    static constexpr auto MAGIC = "HMRZ";
+
+    static constexpr quint32 VERSION = 1;
+
+    //! Amount of uncompressed data collected before a chunk is written.
+    static constexpr int CHUNK_SIZE = 64 * 1024;
+
+    //! Largest compressed chunk accepted when reading. qCompress() output of CHUNK_SIZE bytes always fits,
+    //! so anything bigger is corrupted and must not be allocated.
+    static constexpr quint32 MAX_CHUNK_SIZE = 2 * CHUNK_SIZE;
+
+    explicit CompressedDevice(QIODevice & device);
+
+    virtual ~CompressedDevice();
+
+    //! \return true if the data starts with the magic of a compressed stream.
+    static bool hasMagic(const QByteArray & data);
+
+    //! Reads or writes the header. Only QIODevice::ReadOnly and QIODevice::WriteOnly are supported.
+    virtual bool open(OpenMode mode) override;
+
+    //! Writes the pending data and the terminating chunk when writing.
+    virtual void close() override;
+
+    virtual bool isSequential() const override;
+
+    virtual bool atEnd() const override;
+
+    virtual qint64 bytesAvailable() const override;
+
+protected:
+
+    virtual qint64 readData(char * data, qint64 maxSize) override;
+
+    virtual qint64 writeData(const char * data, qint64 size) override;
+
+private:
+
+    bool readChunk();
+
+    bool writeChunk(const QByteArray & chunk);
+
+    bool fail(QString message);
+
+    QIODevice & m_device;
+
+    QByteArray m_buffer;
+
+    int m_bufferPosition = 0;
+
+    bool m_atEnd = false;
+
+    bool m_failed = false;
+};
+
+#endif // COMPRESSEDDEVICE_HPP
@@ -29,6 +29,18 @@ static constexpr auto COPYRIGHT = "Copyright (c) 2018 Jussi Lind";
 
 static constexpr auto FILE_EXTENSION = ".alz";
 
+//! Extension of the binary sibling of the XML format. See BinaryMapView.
+static constexpr auto BINARY_FILE_EXTENSION = ".alb";
+
+//! Modified mind maps are autosaved at this interval.
+static constexpr int AUTOSAVE_INTERVAL_MS = 60 * 1000;
+
+//! Inserted before the extension of the mind map file name to get the autosave file name.
+static constexpr auto AUTOSAVE_FILE_SUFFIX = ".autosave";
+
+//! Number of parsed mind maps kept in MapCache.
+static constexpr int MAP_CACHE_MAX_ENTRIES = 16;
+
 //! "Company" name used in QSettings.
 static constexpr auto QSETTINGS_COMPANY_NAME = "Heimer";
 
@@ -0,0 +1,155 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "contenthash.hpp"
+#include "edgebase.hpp"
+#include "graph.hpp"
+#include "nodebase.hpp"
+
+#include <QString>
+
+// FNV-1a
+static const uint64_t HASH_BASIS = 14695981039346656037ULL;
+
+static const uint64_t HASH_PRIME = 1099511628211ULL;
+
+static uint64_t hashBytes(uint64_t hash, const void * data, size_t size)
+{
+    const auto bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * HASH_PRIME;
+    }
+
+    return hash;
+}
+
+template<typename T>
+static uint64_t hashValue(uint64_t hash, T value)
+{
+    return hashBytes(hash, &value, sizeof(value));
+}
+
+static uint64_t hashText(uint64_t hash, const QString & text)
+{
+    // The length separates the text from whatever follows
+    hash = hashValue(hash, text.size());
+    return hashBytes(hash, text.constData(), static_cast<size_t>(text.size()) * sizeof(QChar));
+}
+
+static uint64_t nodeHash(const NodeBase & node)
+{
+    auto hash = hashValue(HASH_BASIS, 'n');
+    hash = hashValue(hash, node.index());
+    hash = hashValue(hash, node.location().x());
+    hash = hashValue(hash, node.location().y());
+    hash = hashValue(hash, node.size().width());
+    hash = hashValue(hash, node.size().height());
+    hash = hashValue(hash, node.color().rgba());
+    hash = hashText(hash, node.text());
+    return ContentHash::mix(hash);
+}
+
+static uint64_t edgeHash(const EdgeBase & edge)
+{
+    auto hash = hashValue(HASH_BASIS, 'e');
+    hash = hashValue(hash, edge.sourceNodeBase().index());
+    hash = hashValue(hash, edge.targetNodeBase().index());
+    hash = hashText(hash, edge.text());
+    return ContentHash::mix(hash);
+}
+
+ContentHash::ContentHash(Graph & graph)
+    : m_graph(graph)
+{
+    m_nodeHashes.reserve(graph.getNodes().size());
+    for (auto && node : graph.getNodes())
+    {
+        nodeAdded(*node);
+    }
+
+    m_edgeHashes.reserve(graph.getEdges().size());
+    for (auto && edge : graph.getEdges())
+    {
+        edgeAdded(*edge);
+    }
+
+    m_graph.addObserver(*this);
+}
+
+ContentHash::~ContentHash()
+{
+    m_graph.removeObserver(*this);
+}
+
+uint64_t ContentHash::value() const
+{
+    return m_value;
+}
+
+uint64_t ContentHash::mix(uint64_t value)
+{
+    // Finalizer of SplitMix64 so that the sum doesn't cancel out similar items
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+void ContentHash::nodeAdded(NodeBase & node)
+{
+    const auto hash = nodeHash(node);
+    m_nodeHashes[&node] = hash;
+    m_value += hash;
+}
+
+void ContentHash::nodeRemoved(NodeBase & node)
+{
+    const auto iter = m_nodeHashes.find(&node);
+    if (iter != m_nodeHashes.end())
+    {
+        m_value -= iter->second;
+        m_nodeHashes.erase(iter);
+    }
+}
+
+void ContentHash::nodeChanged(NodeBase & node)
+{
+    nodeRemoved(node);
+    nodeAdded(node);
+}
+
+void ContentHash::edgeAdded(EdgeBase & edge)
+{
+    const auto hash = edgeHash(edge);
+    m_edgeHashes[&edge] = hash;
+    m_value += hash;
+}
+
+void ContentHash::edgeRemoved(EdgeBase & edge)
+{
+    const auto iter = m_edgeHashes.find(&edge);
+    if (iter != m_edgeHashes.end())
+    {
+        m_value -= iter->second;
+        m_edgeHashes.erase(iter);
+    }
+}
+
+void ContentHash::edgeChanged(EdgeBase & edge)
+{
+    edgeRemoved(edge);
+    edgeAdded(edge);
+}
@@ -0,0 +1,73 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef CONTENTHASH_HPP
+#define CONTENTHASH_HPP
+
+#include "graphobserver.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+
+class Graph;
+
+/*! 64-bit hash of the content of a graph that is kept up to date incrementally.
+ *
+ *  Each node and edge is hashed on its own and the hash of the graph is the sum of those,
+ *  so a change only rehashes the changed item and the order of the items doesn't matter.
+ *  Node indices are part of the content, so the hash must be recreated after Graph::compact(). */
+class ContentHash : public GraphObserver
+{
+public:
+
+    explicit ContentHash(Graph & graph);
+
+    ContentHash(const ContentHash & other) = delete;
+
+    ContentHash & operator= (const ContentHash & other) = delete;
+
+    virtual ~ContentHash();
+
+    uint64_t value() const;
+
+    //! \return a well distributed hash of the given value to be mixed with value().
+    static uint64_t mix(uint64_t value);
+
+    virtual void nodeAdded(NodeBase & node) override;
+
+    virtual void nodeRemoved(NodeBase & node) override;
+
+    virtual void nodeChanged(NodeBase & node) override;
+
+    virtual void edgeAdded(EdgeBase & edge) override;
+
+    virtual void edgeRemoved(EdgeBase & edge) override;
+
+    virtual void edgeChanged(EdgeBase & edge) override;
+
+private:
+
+    Graph & m_graph;
+
+    uint64_t m_value = 0;
+
+    //! Hashes of the items as they were added to m_value.
+    std::unordered_map<const NodeBase *, uint64_t> m_nodeHashes;
+
+    std::unordered_map<const EdgeBase *, uint64_t> m_edgeHashes;
+};
+
+#endif // CONTENTHASH_HPP
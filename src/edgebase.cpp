@@ -14,6 +14,7 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "edgebase.hpp"
+#include "graph.hpp"
 #include "nodebase.hpp"
 
 EdgeBase::EdgeBase(NodeBase & sourceNode, NodeBase & targetNode)
@@ -35,6 +36,11 @@ void EdgeBase::setTargetNode(NodeBase & targetNode)
 void EdgeBase::setText(const QString & text)
 {
     m_text = text;
+
+    if (m_graph)
+    {
+        m_graph->notifyEdgeChanged(*this);
+    }
 }
 
 NodeBase & EdgeBase::sourceNodeBase() const
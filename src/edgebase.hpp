@@ -20,6 +20,7 @@
 
 #include <QString>
 
+class Graph;
 class NodeBase;
 
 class EdgeBase
@@ -44,6 +45,11 @@ public:
 
 private:
 
+    friend class Graph;
+
+    //! The graph this edge belongs to, if any
+    Graph * m_graph = nullptr;
+
     NodeBase * m_sourceNode;
 
     NodeBase * m_targetNode;
@@ -15,22 +15,181 @@
 
 #include "editordata.hpp"
 
+#include "changejournal.hpp"
 #include "config.hpp"
+#include "contenthash.hpp"
+#include "graphicsfactory.hpp"
 #include "mediator.hpp"
+#include "mindmaploader.hpp"
 #include "node.hpp"
 #include "serializer.hpp"
-#include "reader.hpp"
 #include "writer.hpp"
 
+#include "mclogger.hh"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QUuid>
+
 #include <cassert>
 #include <memory>
 
 using std::dynamic_pointer_cast;
 using std::make_shared;
 
+class AutosaveTask : public QRunnable
+{
+public:
+
+    AutosaveTask(EditorData & editorData, GraphSnapshotPtr snapshot, QColor backgroundColor, QString fileName)
+        : m_editorData(editorData)
+        , m_snapshot(snapshot)
+        , m_backgroundColor(backgroundColor)
+        , m_fileName(fileName)
+    {
+    }
+
+    virtual void run() override
+    {
+        // The snapshot is immutable so the editor can go on meanwhile. The file is written
+        // aside and renamed in place only if complete, so a crash leaves the previous autosave.
+        QDir().mkpath(QFileInfo(m_fileName).path());
+        const bool success = Writer::writeToFile(*m_snapshot, m_backgroundColor, m_fileName);
+        QMetaObject::invokeMethod(&m_editorData, "finishAutosave", Qt::QueuedConnection, Q_ARG(bool, success));
+    }
+
+private:
+
+    EditorData & m_editorData;
+
+    const GraphSnapshotPtr m_snapshot;
+
+    const QColor m_backgroundColor;
+
+    const QString m_fileName;
+};
+
+static const auto UNTITLED_AUTOSAVE_PREFIX = "untitled";
+
+static QString untitledAutosaveDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+}
+
+static std::unique_ptr<QLockFile> tryLockAutosave(QString autosaveFileName)
+{
+    std::unique_ptr<QLockFile> lock(new QLockFile(autosaveFileName + ".lock"));
+
+    // Only a lock of a process that is gone is stale, no matter how old it is
+    lock->setStaleLockTime(0);
+    if (!lock->tryLock(0))
+    {
+        lock.reset();
+    }
+
+    return lock;
+}
+
 EditorData::EditorData(Mediator & mediator)
     : m_mediator(mediator)
-{}
+    , m_untitledAutosaveFileName(untitledAutosaveDirectory() + "/" + UNTITLED_AUTOSAVE_PREFIX + "-" +
+          QUuid::createUuid().toString().mid(1, 36) + Config::AUTOSAVE_FILE_SUFFIX + Config::BINARY_FILE_EXTENSION)
+{
+    m_autosavePool.setMaxThreadCount(1);
+
+    m_autosaveTimer.setInterval(Config::AUTOSAVE_INTERVAL_MS);
+    connect(&m_autosaveTimer, &QTimer::timeout, this, &EditorData::autosave);
+    m_autosaveTimer.start();
+}
+
+bool EditorData::autosave()
+{
+    if (!m_mindMapData || !m_isModified || m_autosavePool.activeThreadCount())
+    {
+        return false;
+    }
+
+    // This is the only part done in the GUI thread
+    const auto snapshot = m_mindMapData->graph().snapshot();
+    const auto backgroundColor = m_mindMapData->backgroundColor();
+    if (snapshot == m_autosavedSnapshot && backgroundColor == m_autosavedBackgroundColor)
+    {
+        return false;
+    }
+
+    if (m_fileName.isEmpty() && !lockUntitledAutosave())
+    {
+        MCLogger().warning() << "Cannot lock '" << m_untitledAutosaveFileName.toStdString() << "'";
+        return false;
+    }
+
+    m_autosavedSnapshot = snapshot;
+    m_autosavedBackgroundColor = backgroundColor;
+
+    m_autosavePool.start(new AutosaveTask(*this, snapshot, backgroundColor, autosaveFileName()));
+    return true;
+}
+
+QString EditorData::autosaveFileName() const
+{
+    return m_fileName.isEmpty() ? m_untitledAutosaveFileName : autosaveFileName(m_fileName);
+}
+
+QString EditorData::autosaveFileName(QString fileName)
+{
+    assert(!fileName.isEmpty());
+
+    const QFileInfo fileInfo(fileName);
+    return fileInfo.path() + "/" + fileInfo.completeBaseName() + Config::AUTOSAVE_FILE_SUFFIX + Config::BINARY_FILE_EXTENSION;
+}
+
+bool EditorData::hasNewerAutosave(QString fileName)
+{
+    const QFileInfo autosaveInfo(autosaveFileName(fileName));
+    return autosaveInfo.exists() && autosaveInfo.lastModified() > QFileInfo(fileName).lastModified();
+}
+
+QStringList EditorData::orphanedAutosaveFileNames()
+{
+    QStringList fileNames;
+    const QDir directory(untitledAutosaveDirectory());
+    const auto nameFilter = QString(UNTITLED_AUTOSAVE_PREFIX) + "*" + Config::AUTOSAVE_FILE_SUFFIX + Config::BINARY_FILE_EXTENSION;
+    for (auto && fileInfo : directory.entryInfoList({nameFilter}, QDir::Files, QDir::Time))
+    {
+        // Autosaves of running editors are locked
+        if (tryLockAutosave(fileInfo.filePath()))
+        {
+            fileNames << fileInfo.filePath();
+        }
+    }
+
+    return fileNames;
+}
+
+void EditorData::discardOrphanedAutosave(QString autosaveFileName)
+{
+    if (const auto lock = tryLockAutosave(autosaveFileName))
+    {
+        QFile::remove(autosaveFileName);
+    }
+}
+
+void EditorData::finishAutosave(bool success)
+{
+    if (!success)
+    {
+        MCLogger().warning() << "Autosave to '" << autosaveFileName().toStdString() << "' failed";
+
+        // Retry at the next interval
+        m_autosavedSnapshot = nullptr;
+    }
+
+    emit autosaveFinished(success);
+}
 
 QColor EditorData::backgroundColor() const
 {
@@ -53,13 +212,111 @@ QString EditorData::fileName() const
     return m_fileName;
 }
 
-void EditorData::loadMindMapData(QString fileName)
+bool EditorData::isLoading() const
 {
-    setMindMapData(Serializer::fromXml(Reader::readFromFile(fileName)));
+    return m_loader != nullptr;
+}
+
+void EditorData::loadMindMapDataInBackground(QString fileName)
+{
+    loadInBackground(fileName, fileName, false);
+}
+
+void EditorData::recoverMindMapDataInBackground(QString fileName)
+{
+    loadInBackground(autosaveFileName(fileName), fileName, true);
+}
+
+void EditorData::recoverUntitledMindMapDataInBackground(QString autosaveFileName)
+{
+    // Claim the file so that other editors don't recover it, too
+    m_recoveredAutosaveLock = tryLockAutosave(autosaveFileName);
+    if (!m_recoveredAutosaveLock)
+    {
+        emit mindMapLoadFailed("'" + autosaveFileName + "' is in use by another editor");
+        return;
+    }
+
+    m_recoveredAutosaveFileName = autosaveFileName;
+    loadInBackground(autosaveFileName, "", true);
+}
+
+void EditorData::loadInBackground(QString filePath, QString fileName, bool recovered)
+{
+    // Results of a superseded load are dropped
+    if (m_loader)
+    {
+        m_loader->cancel();
+        m_loader = nullptr;
+    }
+
+    const auto loader = new MindMapLoader(filePath, m_mapCache, this);
+    connect(loader, &MindMapLoader::progressChanged, this, [=] (int percent) {
+        // A superseded loader may still report progress until it notices the cancel
+        if (loader == m_loader)
+        {
+            emit loadProgressChanged(percent);
+        }
+    });
+    connect(loader, &QThread::finished, this, [=] () {
+        if (loader == m_loader)
+        {
+            m_loader = nullptr;
+            finishLoading(*loader, fileName, recovered);
+        }
+
+        loader->deleteLater();
+    });
+
+    m_loader = loader;
+    m_loader->start();
+}
+
+void EditorData::cancelLoading()
+{
+    if (m_loader)
+    {
+        m_loader->cancel();
+    }
+}
+
+void EditorData::finishLoading(MindMapLoader & loader, QString fileName, bool recovered)
+{
+    if (loader.mindMapData())
+    {
+        // Copying creates the graphics items for the plain model here in the GUI thread
+        setMindMapData(GraphicsFactory::copyMindMapData(*loader.mindMapData()));
+
+        m_fileName = fileName;
+
+        m_undoStack.clear();
+
+        if (recovered)
+        {
+            // The file doesn't have the recovered content, so the next save must write it
+            m_savedFileSize = -1;
+            setIsModified(true);
+
+            if (fileName.isEmpty() && m_recoveredAutosaveLock)
+            {
+                // Go on autosaving to the recovered file, so it stays until the changes are saved or discarded
+                m_untitledAutosaveFileName = m_recoveredAutosaveFileName;
+                m_untitledAutosaveLock = std::move(m_recoveredAutosaveLock);
+            }
+        }
+        else
+        {
+            markSaved();
+        }
 
-    m_fileName = fileName;
+        emit mindMapLoaded();
+    }
+    else
+    {
+        emit mindMapLoadFailed(loader.isCanceled() ? QString() : loader.errorMessage());
+    }
 
-    m_undoStack.clear();
+    m_recoveredAutosaveLock.reset();
 }
 
 bool EditorData::isModified() const
@@ -84,9 +341,17 @@ void EditorData::undo()
 
         clearScene();
 
+        // The journal follows the replaced graph, so the next save is a full one
+        m_journal.reset();
+
+        m_contentHash.reset();
+
         m_mindMapData = m_undoStack.undo();
 
-        setIsModified(true);
+        trackContent();
+
+        // Returning to the saved state is not a modification
+        setIsModified(!isSaved());
     }
 }
 
@@ -107,9 +372,17 @@ void EditorData::redo()
 
         clearScene();
 
+        // The journal follows the replaced graph, so the next save is a full one
+        m_journal.reset();
+
+        m_contentHash.reset();
+
         m_mindMapData = m_undoStack.redo();
 
-        setIsModified(true);
+        trackContent();
+
+        // Returning to the saved state is not a modification
+        setIsModified(!isSaved());
     }
 }
 
@@ -142,20 +415,89 @@ bool EditorData::saveMindMapAs(QString fileName)
 {
     assert(m_mindMapData);
 
-    if (Writer::writeToFile(Serializer::toXml(*m_mindMapData), fileName))
+    // Don't touch the file at all if it already has this content
+    if (fileName == m_fileName && isSaved() && isSavedFileUnchanged())
     {
+        removeAutosaveFile(autosaveFileName());
+
+        setIsModified(false);
+        return true;
+    }
+
+    // Only the changes since the previous save need to be written as long as the journal keeps up
+    if (m_journal && fileName == m_fileName && m_journal->isRecording(*m_mindMapData) && !m_journal->isFull())
+    {
+        if (m_journal->append())
+        {
+            removeAutosaveFile(autosaveFileName());
+
+            markSaved();
+            setIsModified(false);
+            return true;
+        }
+
+        MCLogger().warning() << "Cannot append to the journal of '" << fileName.toStdString() << "', saving in full";
+    }
+
+    const auto format = m_isCompactFileFormatEnabled ? Serializer::Format::Tables : Serializer::Format::Inline;
+    if (Writer::writeToFile(*m_mindMapData, fileName, m_isCompressionEnabled, format))
+    {
+        // The autosave is obsolete now
+        removeAutosaveFile(autosaveFileName());
+
         m_fileName = fileName;
+
+        // The file has the nodes numbered densely, so renumber the model to match. The journal and
+        // the content hash track indices but are not notified, so they are restarted afterwards.
+        m_journal.reset();
+        m_mindMapData->graph().compact();
+        trackContent();
+        markSaved();
         setIsModified(false);
+
+        startJournal();
         return true;
     }
 
     return false;
 }
 
+void EditorData::setCompactFileFormatEnabled(bool enabled)
+{
+    m_isCompactFileFormatEnabled = enabled;
+}
+
+void EditorData::setCompressionEnabled(bool enabled)
+{
+    m_isCompressionEnabled = enabled;
+}
+
+void EditorData::setJournalingEnabled(bool enabled)
+{
+    m_isJournalingEnabled = enabled;
+    if (!enabled)
+    {
+        m_journal.reset();
+    }
+}
+
+void EditorData::setMapCache(const MapCache & mapCache)
+{
+    m_mapCache = mapCache;
+}
+
 void EditorData::setMindMapData(MindMapDataPtr mindMapData)
 {
+    removeCurrentAutosaveFile();
+
+    m_journal.reset();
+
+    m_contentHash.reset();
+
     m_mindMapData = mindMapData;
 
+    trackContent();
+
     m_fileName = "";
     setIsModified(false);
 }
@@ -200,6 +542,94 @@ Node * EditorData::selectedNode() const
     return m_selectedNode;
 }
 
+void EditorData::trackContent()
+{
+    m_contentHash.reset(m_mindMapData ? new ContentHash(m_mindMapData->graph()) : nullptr);
+}
+
+uint64_t EditorData::contentHash() const
+{
+    assert(m_contentHash);
+
+    return m_contentHash->value() + ContentHash::mix(m_mindMapData->backgroundColor().rgba());
+}
+
+bool EditorData::isSaved() const
+{
+    return !m_fileName.isEmpty() && m_contentHash && contentHash() == m_savedContentHash;
+}
+
+bool EditorData::isSavedFileUnchanged() const
+{
+    const QFileInfo fileInfo(m_fileName);
+    return fileInfo.exists() && fileInfo.size() == m_savedFileSize && fileInfo.lastModified() == m_savedFileModified;
+}
+
+void EditorData::markSaved()
+{
+    if (m_contentHash)
+    {
+        m_savedContentHash = contentHash();
+    }
+
+    const QFileInfo fileInfo(m_fileName);
+    m_savedFileSize = fileInfo.exists() ? fileInfo.size() : -1;
+    m_savedFileModified = fileInfo.lastModified();
+}
+
+void EditorData::startJournal()
+{
+    m_journal.reset();
+
+    if (m_isJournalingEnabled)
+    {
+        m_journal.reset(new ChangeJournal(m_fileName));
+        if (!m_journal->start(m_mindMapData))
+        {
+            MCLogger().warning() << "Cannot start the journal of '" << m_fileName.toStdString() << "'";
+            m_journal.reset();
+        }
+    }
+    else
+    {
+        QFile::remove(ChangeJournal::journalFileName(m_fileName));
+    }
+}
+
+void EditorData::removeAutosaveFile(QString autosaveFileName)
+{
+    // A pending autosave would bring the file back
+    m_autosavePool.waitForDone();
+
+    QFile::remove(autosaveFileName);
+
+    if (autosaveFileName == m_untitledAutosaveFileName)
+    {
+        m_untitledAutosaveLock.reset();
+    }
+
+    m_autosavedSnapshot = nullptr;
+}
+
+bool EditorData::lockUntitledAutosave()
+{
+    if (!m_untitledAutosaveLock)
+    {
+        QDir().mkpath(untitledAutosaveDirectory());
+        m_untitledAutosaveLock = tryLockAutosave(m_untitledAutosaveFileName);
+    }
+
+    return m_untitledAutosaveLock != nullptr;
+}
+
+void EditorData::removeCurrentAutosaveFile()
+{
+    if (m_mindMapData)
+    {
+        removeAutosaveFile(autosaveFileName());
+    }
+}
+
 void EditorData::removeNodesFromScene()
 {
     if (m_mindMapData)
@@ -219,3 +649,19 @@ void EditorData::setIsModified(bool isModified)
         emit isModifiedChanged(isModified);
     }
 }
+
+EditorData::~EditorData()
+{
+    // The map is closed either saved or discarded, so its autosave is no longer needed
+    removeCurrentAutosaveFile();
+
+    // The autosave task refers to this object
+    m_autosavePool.waitForDone();
+
+    // Loaders are children of this object and may still be running
+    for (auto && loader : findChildren<MindMapLoader *>())
+    {
+        loader->cancel();
+        loader->wait();
+    }
+}
@@ -16,25 +16,36 @@
 #ifndef EDITORDATA_HPP
 #define EDITORDATA_HPP
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include <QDateTime>
 #include <QObject>
 #include <QPointF>
 #include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
 
 #include "draganddropstore.hpp"
 #include "edge.hpp"
 #include "fileexception.hpp"
+#include "graphsnapshot.hpp"
+#include "mapcache.hpp"
 #include "undostack.hpp"
 #include "mindmapdata.hpp"
 #include "node.hpp"
 
+class ChangeJournal;
+class ContentHash;
 class Mediator;
+class MindMapLoader;
 class Node;
 class NodeBase;
 class MindMapTile;
 class QGraphicsLineItem;
+class QLockFile;
 
 class EditorData : public QObject
 {
@@ -44,12 +55,38 @@ public:
 
     EditorData(Mediator & mediator);
 
+    virtual ~EditorData();
+
     EdgePtr addEdge(EdgePtr edge);
 
     NodePtr addNodeAt(QPointF pos);
 
+    /*! Takes a snapshot of a modified mind map and writes it to autosaveFileName() in a worker thread.
+     *  Called periodically. Emits autosaveFinished() when done.
+     *  \return false if nothing has changed since the last autosave or if the previous one is still running. */
+    bool autosave();
+
+    /*! \return the binary file next to the mind map file, or a file of this editor in the application data
+     *  directory if there's no file yet. The latter is locked while in use so that other instances leave it alone. */
+    QString autosaveFileName() const;
+
+    //! \return the autosave file of the given mind map file like above.
+    static QString autosaveFileName(QString fileName);
+
+    //! \return autosaves of new mind maps that no running editor owns, e.g. after a crash. The newest comes first.
+    static QStringList orphanedAutosaveFileNames();
+
+    //! Removes an autosave of orphanedAutosaveFileNames() whose changes are not wanted.
+    static void discardOrphanedAutosave(QString autosaveFileName);
+
+    //! \return true if the given mind map file has an autosave that is newer than the file, e.g. after a crash.
+    static bool hasNewerAutosave(QString fileName);
+
     QColor backgroundColor() const;
 
+    //! Cancels the background load, which then finishes with mindMapLoadFailed() and an empty message.
+    void cancelLoading();
+
     DragAndDropStore & dadStore();
 
     QString fileName() const;
@@ -62,7 +99,19 @@ public:
 
     bool isModified() const;
 
-    void loadMindMapData(QString fileName);
+    bool isLoading() const;
+
+    /*! Loads the mind map in a background thread. Emits loadProgressChanged() meanwhile and finally either
+     *  mindMapLoaded() or mindMapLoadFailed(). The current mind map is kept until the loading has succeeded. */
+    void loadMindMapDataInBackground(QString fileName);
+
+    /*! Loads the autosave of the given mind map file in the background like loadMindMapDataInBackground().
+     *  The result belongs to the given file and is modified until saved to it. */
+    void recoverMindMapDataInBackground(QString fileName);
+
+    /*! Loads an autosave of orphanedAutosaveFileNames() in the background like loadMindMapDataInBackground().
+     *  The result is a new mind map that is modified until saved. It keeps autosaving to the same file. */
+    void recoverUntitledMindMapDataInBackground(QString autosaveFileName);
 
     MindMapDataPtr mindMapData();
 
@@ -70,12 +119,28 @@ public:
 
     bool saveMindMap();
 
+    /*! Saves the mind map to the given file. Saving again to the same file only appends the changes
+     *  to a ChangeJournal until it's full or the mind map has been replaced by undo or redo. */
     bool saveMindMapAs(QString fileName);
 
     void saveUndoPoint();
 
     void saveRedoPoint();
 
+    //! Full saves write XML in Serializer::Format::Tables when enabled. Disabled by default,
+    //! because older versions cannot read that format.
+    void setCompactFileFormatEnabled(bool enabled);
+
+    //! Full saves write compressed XML when enabled. Disabled by default.
+    void setCompressionEnabled(bool enabled);
+
+    /*! Journaling is disabled by default, because the mind map file alone is not up to date
+     *  while it has a journal. Without journaling every save is a full one. */
+    void setJournalingEnabled(bool enabled);
+
+    //! Parsed XML files are cached in MapCache::defaultDirectory() by default.
+    void setMapCache(const MapCache & mapCache);
+
     void setMindMapData(MindMapDataPtr newMindMapData);
 
     void setSelectedNode(Node * node);
@@ -86,8 +151,21 @@ public:
 
 signals:
 
+    void autosaveFinished(bool success);
+
     void isModifiedChanged(bool isModified);
 
+    void loadProgressChanged(int percent);
+
+    void mindMapLoaded();
+
+    //! The message is empty if the loading was canceled.
+    void mindMapLoadFailed(QString errorMessage);
+
+private slots:
+
+    void finishAutosave(bool success);
+
 private:
 
     EditorData(const EditorData & e) = delete;
@@ -95,10 +173,38 @@ private:
 
     void clearScene();
 
+    //! \return hash of the current content including the background color.
+    uint64_t contentHash() const;
+
+    //! Takes the loaded mind map as the content of the given file. A recovered mind map is not saved yet.
+    void finishLoading(MindMapLoader & loader, QString fileName, bool recovered);
+
+    void loadInBackground(QString filePath, QString fileName, bool recovered);
+
+    //! \return true if the content equals to what was last loaded from or saved to the file.
+    bool isSaved() const;
+
+    //! \return true if the file still has the size and the modification time it had when last loaded or saved.
+    bool isSavedFileUnchanged() const;
+
+    void markSaved();
+
+    void removeAutosaveFile(QString autosaveFileName);
+
+    //! Removes the autosave of the current mind map when it's closed or replaced. Its changes were either saved or discarded.
+    void removeCurrentAutosaveFile();
+
     void removeNodesFromScene();
 
+    //! \return false if the untitled autosave file is locked by another editor.
+    bool lockUntitledAutosave();
+
     void setIsModified(bool isModified);
 
+    void startJournal();
+
+    void trackContent();
+
     DragAndDropStore m_dadStore;
 
     MindMapDataPtr m_mindMapData;
@@ -113,6 +219,8 @@ private:
 
     Mediator & m_mediator;
 
+    MindMapLoader * m_loader = nullptr;
+
     std::vector<QGraphicsLineItem *> m_targetNodes;
 
     unsigned int m_activeColumn = 0;
@@ -121,7 +229,46 @@ private:
 
     bool m_isModified = false;
 
+    bool m_isCompactFileFormatEnabled = false;
+
+    bool m_isCompressionEnabled = false;
+
+    bool m_isJournalingEnabled = false;
+
+    std::unique_ptr<ChangeJournal> m_journal;
+
+    MapCache m_mapCache;
+
+    std::unique_ptr<ContentHash> m_contentHash;
+
+    uint64_t m_savedContentHash = 0;
+
+    qint64 m_savedFileSize = -1;
+
+    QDateTime m_savedFileModified;
+
     QString m_fileName;
+
+    QTimer m_autosaveTimer;
+
+    //! Runs one autosave at a time.
+    QThreadPool m_autosavePool;
+
+    //! The snapshot last handed to the autosave. Unchanged graphs return the same snapshot.
+    GraphSnapshotPtr m_autosavedSnapshot;
+
+    QColor m_autosavedBackgroundColor;
+
+    //! Unique per editor so that instances don't overwrite each other's autosaves.
+    QString m_untitledAutosaveFileName;
+
+    //! Held while m_untitledAutosaveFileName exists.
+    std::unique_ptr<QLockFile> m_untitledAutosaveLock;
+
+    //! Orphaned autosave being recovered and its lock. Taken over if the loading succeeds.
+    QString m_recoveredAutosaveFileName;
+
+    std::unique_ptr<QLockFile> m_recoveredAutosaveLock;
 };
 
 #endif // EDITORDATA_HPP
@@ -16,6 +16,7 @@
 #include "editorscene.hpp"
 #include "edge.hpp"
 #include "node.hpp"
+#include "nodestore.hpp"
 
 #include "contrib/mclogger.hh"
 
@@ -47,21 +48,20 @@ EditorScene::EditorScene()
     addItem(bottomLine);
 }
 
-QRectF EditorScene::getNodeBoundingRectWithHeuristics() const
+QRectF EditorScene::getNodeBoundingRectWithHeuristics(const NodeStore & nodeStore) const
 {
+    // Leave room for the node handles like the bounding rects of the graphics items do
+    const qreal margin = 32;
+    const QRectF rect = nodeStore.boundingRect().adjusted(-margin, -margin, margin, margin);
+
     float nodeArea = 0;
-    QRectF rect;
-    int nodes = 0;
-    for (auto && item : items())
+    for (auto && size : nodeStore.sizes())
     {
-        if (auto node = dynamic_cast<Node *>(item))
-        {
-            rect = rect.united(node->boundingRect().adjusted(node->pos().x(), node->pos().y(), node->pos().x(), node->pos().y()));
-            nodeArea += node->boundingRect().width() * node->boundingRect().height();
-            nodes++;
-        }
+        nodeArea += (size.width() + margin * 2) * (size.height() + margin * 2);
     }
 
+    const int nodes = static_cast<int>(nodeStore.sizes().size());
+
     // This "don't ask" heuristics tries to calculate a "nice" zoom-to-fit based on the design
     // density and node count. For example, if we have just a single node we don't want it to
     // be super big and cover the whole screen.
@@ -19,6 +19,7 @@
 #include <QGraphicsScene>
 
 class Node;
+class NodeStore;
 
 class EditorScene : public QGraphicsScene
 {
@@ -26,7 +27,7 @@ public:
 
     EditorScene();
 
-    QRectF getNodeBoundingRectWithHeuristics() const;
+    QRectF getNodeBoundingRectWithHeuristics(const NodeStore & nodeStore) const;
 
     bool hasEdge(Node & node0, Node & node1);
 
@@ -22,23 +22,170 @@
 #include <cassert>
 #include <cmath>
 
+static uint64_t edgeKey(const EdgeBase & edge)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(edge.sourceNodeBase().index())) << 32) |
+        static_cast<uint32_t>(edge.targetNodeBase().index());
+}
+
 Graph::Graph()
+    : m_nodeStore(*this)
 {
 }
 
 void Graph::clear()
 {
+    const auto edges = std::move(m_edges);
+    const auto nodes = std::move(m_nodes);
+
+    m_count = 0;
+    m_freeIndices.clear();
+    m_nodeStore.clear();
     m_nodes.clear();
+    m_edges.clear();
+    m_nodeIndexMap.clear();
+    m_edgeKeys.clear();
+    m_edgesFromNode.clear();
+    m_edgesToNode.clear();
+    m_generation++;
+
+    for (auto && edge : edges)
+    {
+        edge->m_graph = nullptr;
+        for (auto && observer : m_observers)
+        {
+            observer->edgeRemoved(*edge);
+        }
+    }
+
+    for (auto && node : nodes)
+    {
+        for (auto && observer : m_observers)
+        {
+            observer->nodeRemoved(*node);
+        }
+    }
+}
+
+void Graph::reserve(size_t nodes, size_t edges)
+{
+    m_nodes.reserve(nodes);
+    m_nodeStore.reserve(nodes);
+    m_nodeIndexMap.reserve(nodes);
+    m_edgesFromNode.reserve(nodes);
+    m_edgesToNode.reserve(nodes);
+    m_edges.reserve(edges);
+    m_edgeKeys.reserve(edges);
+}
+
+void Graph::build(const NodeVector & nodes, const EdgeVector & edges)
+{
+    reserve(m_nodes.size() + nodes.size(), m_edges.size() + edges.size());
+
+    NodeVector addedNodes;
+    addedNodes.reserve(nodes.size());
+    for (auto && node : nodes)
+    {
+        if (node->index() != -1 && m_nodeIndexMap.count(node->index()))
+        {
+            MCLogger().warning() << "Skipping node with duplicate index " << node->index();
+            continue;
+        }
+
+        attachNode(node);
+        addedNodes.push_back(node);
+    }
+
+    const auto isInGraph = [this] (const NodeBase & node) {
+        const auto iter = m_nodeIndexMap.find(node.index());
+        return iter != m_nodeIndexMap.end() && iter->second.get() == &node;
+    };
+
+    EdgeVector addedEdges;
+    addedEdges.reserve(edges.size());
+    for (auto && edge : edges)
+    {
+        if (!isInGraph(edge->sourceNodeBase()) || !isInGraph(edge->targetNodeBase()))
+        {
+            MCLogger().warning() << "Skipping edge " << edge->sourceNodeBase().index() << " -> "
+                                 << edge->targetNodeBase().index() << " with unknown nodes";
+        }
+        else if (attachEdge(edge))
+        {
+            addedEdges.push_back(edge);
+        }
+    }
+
+    if (addedNodes.empty() && addedEdges.empty())
+    {
+        return;
+    }
+
+    m_generation++;
+
+    for (auto && observer : m_observers)
+    {
+        observer->nodesAndEdgesAdded(addedNodes, addedEdges);
+    }
+}
+
+void Graph::compact()
+{
+    // The store is in node order so the new indices are the slots
+    m_nodeStore.renumber();
+
+    m_count = static_cast<int>(m_nodes.size());
+    m_freeIndices.clear();
+    m_nodeIndexMap.clear();
+    for (auto && node : m_nodes)
+    {
+        m_nodeIndexMap.emplace(node->index(), node);
+    }
+
+    // Rebuild the index-keyed edge lookups. The edges keep their relative order.
+    m_edgeKeys.clear();
+    m_edgesFromNode.clear();
+    m_edgesToNode.clear();
+    for (auto && edge : m_edges)
+    {
+        m_edgeKeys.insert(edgeKey(*edge));
+        m_edgesFromNode[edge->sourceNodeBase().index()].push_back(edge);
+        m_edgesToNode[edge->targetNodeBase().index()].push_back(edge);
+    }
+
+    m_generation++;
 }
 
 void Graph::addNode(NodeBasePtr node)
+{
+    attachNode(node);
+    m_generation++;
+
+    for (auto && observer : m_observers)
+    {
+        observer->nodeAdded(*node);
+    }
+}
+
+void Graph::attachNode(NodeBasePtr node)
 {
     if (node->index() == -1)
     {
-        node->setIndex(m_count++);
+        // Recycle the lowest index of deleted nodes, if any
+        if (!m_freeIndices.empty())
+        {
+            node->setIndex(*m_freeIndices.begin());
+            m_freeIndices.erase(m_freeIndices.begin());
+        }
+        else
+        {
+            node->setIndex(m_count++);
+        }
     }
     else
     {
+        m_freeIndices.erase(node->index());
+
         if (node->index() >= m_count)
         {
             m_count = node->index() + 1;
@@ -46,70 +193,179 @@ void Graph::addNode(NodeBasePtr node)
     }
 
     m_nodes.push_back(node);
+    m_nodeStore.attach(*node);
+    m_nodeIndexMap.emplace(node->index(), node);
 }
 
 void Graph::deleteNode(int index)
 {
-    const auto iter = std::find_if(m_nodes.begin(), m_nodes.end(), [=] (const NodeBasePtr & node) {
-        return node->index() == index;
-    });
+    deleteNodes({index});
+}
 
-    if (iter != m_nodes.end())
+void Graph::deleteNodes(const std::vector<int> & indices)
+{
+    std::unordered_set<int> deletedNodes;
+    for (auto && index : indices)
     {
-        EdgeVector::iterator edgeIter;
-        bool edgeErased = false;
-        do
+        if (m_nodeIndexMap.count(index))
         {
-            edgeIter = std::find_if(
-                m_edges.begin(), m_edges.end(), [=](const EdgeBasePtr & edge){
-                    return edge->sourceNodeBase().index() == index ||
-                           edge->targetNodeBase().index() == index;
-                });
-            edgeErased = edgeIter != m_edges.end();
-            if (edgeErased)
+            deletedNodes.insert(index);
+        }
+    }
+
+    if (deletedNodes.empty())
+    {
+        return;
+    }
+
+    // Collect all edges involving the deleted nodes and the surviving nodes at their other ends.
+    // The pointer vectors keep the deleted objects alive until the observers have been notified.
+    NodeVector deletedNodePtrs;
+    EdgeVector deletedEdgePtrs;
+    std::unordered_set<EdgeBase *> deletedEdges;
+    std::unordered_set<int> affectedSources;
+    std::unordered_set<int> affectedTargets;
+    for (auto && index : deletedNodes)
+    {
+        for (auto && edge : m_edgesFromNode[index])
+        {
+            if (deletedEdges.insert(edge.get()).second)
             {
-                m_edges.erase(edgeIter);
+                deletedEdgePtrs.push_back(edge);
             }
-        } while (edgeErased);
+            affectedTargets.insert(edge->targetNodeBase().index());
+        }
+
+        for (auto && edge : m_edgesToNode[index])
+        {
+            if (deletedEdges.insert(edge.get()).second)
+            {
+                deletedEdgePtrs.push_back(edge);
+            }
+            affectedSources.insert(edge->sourceNodeBase().index());
+        }
+
+        deletedNodePtrs.push_back(m_nodeIndexMap[index]);
+
+        m_edgesFromNode.erase(index);
+        m_edgesToNode.erase(index);
+        m_nodeIndexMap.erase(index);
+        m_freeIndices.insert(index);
+    }
+
+    for (auto && edge : deletedEdgePtrs)
+    {
+        m_edgeKeys.erase(edgeKey(*edge));
+    }
 
-        m_nodes.erase(iter);
+    const auto isDeletedEdge = [&] (const EdgeBasePtr & edge) {
+        return deletedEdges.count(edge.get()) > 0;
+    };
+
+    const auto eraseDeletedEdges = [&] (EdgeVector & edges) {
+        edges.erase(std::remove_if(edges.begin(), edges.end(), isDeletedEdge), edges.end());
+    };
+
+    for (auto && index : affectedSources)
+    {
+        if (!deletedNodes.count(index))
+        {
+            eraseDeletedEdges(m_edgesFromNode[index]);
+        }
+    }
+
+    for (auto && index : affectedTargets)
+    {
+        if (!deletedNodes.count(index))
+        {
+            eraseDeletedEdges(m_edgesToNode[index]);
+        }
+    }
+
+    eraseDeletedEdges(m_edges);
+
+    m_nodeStore.detach(deletedNodes);
+
+    m_nodes.erase(std::remove_if(m_nodes.begin(), m_nodes.end(), [&] (const NodeBasePtr & node) {
+        return deletedNodes.count(node->index()) > 0;
+    }), m_nodes.end());
+
+    m_generation++;
+
+    for (auto && edge : deletedEdgePtrs)
+    {
+        edge->m_graph = nullptr;
+        for (auto && observer : m_observers)
+        {
+            observer->edgeRemoved(*edge);
+        }
+    }
+
+    for (auto && node : deletedNodePtrs)
+    {
+        for (auto && observer : m_observers)
+        {
+            observer->nodeRemoved(*node);
+        }
     }
 }
 
 void Graph::addEdge(EdgeBasePtr newEdge)
 {
     // Add if such edge doesn't already exist
-    if (std::count_if(
-        m_edges.begin(), m_edges.end(), [=](const EdgeBasePtr & edge){
-            return edge->sourceNodeBase().index() == newEdge->sourceNodeBase().index() &&
-                   edge->targetNodeBase().index() == newEdge->targetNodeBase().index();
-        }) == 0)
+    if (attachEdge(newEdge))
     {
-        m_edges.push_back(newEdge);
+        m_generation++;
+
+        for (auto && observer : m_observers)
+        {
+            observer->edgeAdded(*newEdge);
+        }
     }
 }
 
-#ifdef HEIMER_UNIT_TEST
-void Graph::addEdge(int node0, int node1)
+bool Graph::attachEdge(EdgeBasePtr edge)
 {
-    // Add if such edge doesn't already exist
-    if (std::count_if(
-        m_edges.begin(), m_edges.end(), [=](const EdgeBasePtr & edge){
-            return edge->sourceNodeBase().index() == node0 && edge->targetNodeBase().index() == node1;
-        }) == 0)
+    // A single lookup both checks for doubles and records the key
+    if (!m_edgeKeys.insert(edgeKey(*edge)).second)
     {
-        m_edges.push_back(std::make_shared<EdgeBase>(*getNode(node0), *getNode(node1)));
+        return false;
+    }
+
+    m_edges.push_back(edge);
+    m_edgesFromNode[edge->sourceNodeBase().index()].push_back(edge);
+    m_edgesToNode[edge->targetNodeBase().index()].push_back(edge);
+    edge->m_graph = this;
+    return true;
+}
+
+void Graph::notifyEdgeChanged(EdgeBase & edge)
+{
+    m_generation++;
+
+    for (auto && observer : m_observers)
+    {
+        observer->edgeChanged(edge);
+    }
+}
+
+void Graph::notifyNodeChanged(NodeBase & node)
+{
+    m_generation++;
+
+    for (auto && observer : m_observers)
+    {
+        observer->nodeChanged(node);
     }
 }
-#endif
 
 bool Graph::areDirectlyConnected(NodeBasePtr node0, NodeBasePtr node1)
 {
-    const auto nodes = getNodesConnectedToNode(node0);
-    return std::count_if(
-        nodes.begin(), nodes.end(), [=] (const NodeBasePtr & node) {
-            return node->index() == node1->index();
-        }) > 0;
+    bool connected = false;
+    forEachNodeConnectedToNode(node0->index(), [&] (NodeBase & node) {
+        connected = connected || node.index() == node1->index();
+    });
+    return connected;
 }
 
 int Graph::numNodes() const
@@ -117,6 +373,11 @@ int Graph::numNodes() const
     return m_nodes.size();
 }
 
+int Graph::numEdges() const
+{
+    return m_edges.size();
+}
+
 const Graph::EdgeVector & Graph::getEdges() const
 {
     return m_edges;
@@ -124,36 +385,20 @@ const Graph::EdgeVector & Graph::getEdges() const
 
 Graph::EdgeVector Graph::getEdgesFromNode(NodeBasePtr node)
 {
-    Graph::EdgeVector edges;
-    for (auto && edge : m_edges)
-    {
-        if (edge->sourceNodeBase().index() == node->index())
-        {
-            edges.push_back(edge);
-        }
-    }
-    return edges;
+    const auto iter = m_edgesFromNode.find(node->index());
+    return iter != m_edgesFromNode.end() ? iter->second : EdgeVector();
 }
 
 Graph::EdgeVector Graph::getEdgesToNode(NodeBasePtr node)
 {
-    Graph::EdgeVector edges;
-    for (auto && edge : m_edges)
-    {
-        if (edge->targetNodeBase().index() == node->index())
-        {
-            edges.push_back(edge);
-        }
-    }
-    return edges;
+    const auto iter = m_edgesToNode.find(node->index());
+    return iter != m_edgesToNode.end() ? iter->second : EdgeVector();
 }
 
 NodeBasePtr Graph::getNode(int index)
 {
-    auto iter = std::find_if(m_nodes.begin(), m_nodes.end(), [=] (const NodeBasePtr & node) {
-        return node->index() == index;
-    });
-    return iter != m_nodes.end() ? *iter : NodeBasePtr();
+    const auto iter = m_nodeIndexMap.find(index);
+    return iter != m_nodeIndexMap.end() ? iter->second : NodeBasePtr();
 }
 
 const Graph::NodeVector & Graph::getNodes() const
@@ -164,24 +409,67 @@ const Graph::NodeVector & Graph::getNodes() const
 Graph::NodeVector Graph::getNodesConnectedToNode(NodeBasePtr node)
 {
     NodeVector result;
+    result.reserve(numEdgesFromNode(node->index()) + numEdgesToNode(node->index()));
 
-    auto && from = getEdgesFromNode(node);
-    auto && to = getEdgesToNode(node);
+    forEachNodeConnectedToNode(node->index(), [&] (NodeBase & connectedNode) {
+        result.push_back(getNode(connectedNode.index()));
+    });
 
-    for (auto && edge : to)
-    {
-        result.push_back(getNode(edge->sourceNodeBase().index()));
-    }
+    return result;
+}
 
-    for (auto && edge : from)
+const NodeStore & Graph::nodeStore() const
+{
+    return m_nodeStore;
+}
+
+GraphSnapshotPtr Graph::snapshot() const
+{
+    if (!m_snapshot || m_snapshotGeneration != m_generation)
     {
-        result.push_back(getNode(edge->targetNodeBase().index()));
+        m_snapshot = std::make_shared<GraphSnapshot>(*this);
+        m_snapshotGeneration = m_generation;
     }
 
-    return result;
+    return m_snapshot;
+}
+
+void Graph::addObserver(GraphObserver & observer)
+{
+    m_observers.push_back(&observer);
+}
+
+void Graph::removeObserver(GraphObserver & observer)
+{
+    m_observers.erase(std::remove(m_observers.begin(), m_observers.end(), &observer), m_observers.end());
+}
+
+uint64_t Graph::generation() const
+{
+    return m_generation;
+}
+
+int Graph::numEdgesFromNode(int index) const
+{
+    const auto iter = m_edgesFromNode.find(index);
+    return iter != m_edgesFromNode.end() ? static_cast<int>(iter->second.size()) : 0;
+}
+
+int Graph::numEdgesToNode(int index) const
+{
+    const auto iter = m_edgesToNode.find(index);
+    return iter != m_edgesToNode.end() ? static_cast<int>(iter->second.size()) : 0;
 }
 
 Graph::~Graph()
 {
+    // Nodes and edges may outlive the graph so detach them
+    m_nodeStore.clear();
+
+    for (auto && edge : m_edges)
+    {
+        edge->m_graph = nullptr;
+    }
+
     MCLogger().debug() << "Graph deleted";
 }
@@ -18,9 +18,16 @@
 
 #include "nodebase.hpp"
 #include "edgebase.hpp"
+#include "graphobserver.hpp"
+#include "graphsnapshot.hpp"
+#include "nodestore.hpp"
 
+#include <cstdint>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class NodeBase;
 
@@ -42,20 +49,34 @@ public:
 
     void clear();
 
+    //! Reserves room for the given total amounts of nodes and edges in all internal containers.
+    void reserve(size_t nodes, size_t edges);
+
+    //! Adds nodes and then edges between them in one go. Nodes with an index already in use, double edges
+    //! and edges whose nodes are not in the graph are skipped. Observers are notified once with
+    //! GraphObserver::nodesAndEdgesAdded() after everything has been inserted.
+    void build(const NodeVector & nodes, const EdgeVector & edges);
+
+    //! Renumbers nodes densely to 0..numNodes() - 1 in their insertion order, which is also how
+    //! they are numbered in saved files. Edges follow automatically as they refer to the node objects.
+    //! Observers are not notified, so trackers of indices need to be restarted afterwards.
+    void compact();
+
     void addNode(NodeBasePtr node);
 
     void deleteNode(int index);
 
+    //! Deletes given nodes and all edges involving them in a single pass.
+    void deleteNodes(const std::vector<int> & indices);
+
     void addEdge(EdgeBasePtr edge);
 
     bool areDirectlyConnected(NodeBasePtr node0, NodeBasePtr node1);
 
-    //! Warning: this should not be used outside unit tests as it creates a pure EdgeBase
-#ifdef HEIMER_UNIT_TEST
-    void addEdge(int node0, int node1);
-#endif
     int numNodes() const;
 
+    int numEdges() const;
+
     EdgeVector getEdgesFromNode(NodeBasePtr node);
 
     EdgeVector getEdgesToNode(NodeBasePtr node);
@@ -66,15 +87,153 @@ public:
 
     const NodeVector & getNodes() const;
 
+    //! \return packed node attributes in the order of getNodes().
+    const NodeStore & nodeStore() const;
+
     NodeVector getNodesConnectedToNode(NodeBasePtr node);
 
+    //! \return an immutable copy of the graph for read-only consumers, e.g. worker threads.
+    //! The same snapshot is returned until the graph changes.
+    GraphSnapshotPtr snapshot() const;
+
+    void addObserver(GraphObserver & observer);
+
+    void removeObserver(GraphObserver & observer);
+
+    //! \return a counter that is incremented on every change to the graph including node and edge attributes.
+    uint64_t generation() const;
+
+    int numEdgesFromNode(int index) const;
+
+    int numEdgesToNode(int index) const;
+
+    //! Calls function(EdgeBase &) for each edge from the given node. Nothing is allocated or copied.
+    template<typename Function>
+    void forEachEdgeFromNode(int index, Function && function) const;
+
+    //! Calls function(EdgeBase &) for each edge to the given node. Nothing is allocated or copied.
+    template<typename Function>
+    void forEachEdgeToNode(int index, Function && function) const;
+
+    /*! Calls function(int position, const QPointF & location, const QSizeF & size, const QColor & color, const QString & text)
+     *  for each node in the order of getNodes(). The same as GraphSnapshot::forEachNode() but on the live graph. */
+    template<typename Function>
+    void forEachNode(Function && function) const;
+
+    //! Calls function(int targetPosition, const QString & text) for each edge from the node at given position.
+    template<typename Function>
+    void forEachEdgeFromPosition(int position, Function && function) const;
+
+    //! Calls function(NodeBase &) for each node connected to the given node.
+    //! The order is the same as in getNodesConnectedToNode().
+    template<typename Function>
+    void forEachNodeConnectedToNode(int index, Function && function) const;
+
 private:
 
+    friend class EdgeBase;
+
+    friend class NodeStore;
+
+    //! Inserts the node into the containers without notifying observers.
+    void attachNode(NodeBasePtr node);
+
+    //! Inserts the edge into the containers without notifying observers.
+    //! \return false if such edge already exists.
+    bool attachEdge(EdgeBasePtr edge);
+
+    void notifyEdgeChanged(EdgeBase & edge);
+
+    void notifyNodeChanged(NodeBase & node);
+
     NodeVector m_nodes;
 
+    NodeStore m_nodeStore;
+
     EdgeVector m_edges;
 
+    //! Maps node index => node so that getNode() doesn't need to do linear searches.
+    std::unordered_map<int, NodeBasePtr> m_nodeIndexMap;
+
+    //! Keys of (source index, target index) pairs of all edges for fast duplicate checks.
+    std::unordered_set<uint64_t> m_edgeKeys;
+
+    //! Maps node index => outgoing edges.
+    std::unordered_map<int, EdgeVector> m_edgesFromNode;
+
+    //! Maps node index => incoming edges.
+    std::unordered_map<int, EdgeVector> m_edgesToNode;
+
+    //! Indices of deleted nodes that can be given to new nodes.
+    std::set<int> m_freeIndices;
+
     int m_count = 0;
+
+    std::vector<GraphObserver *> m_observers;
+
+    uint64_t m_generation = 0;
+
+    mutable GraphSnapshotPtr m_snapshot;
+
+    mutable uint64_t m_snapshotGeneration = 0;
 };
 
+template<typename Function>
+void Graph::forEachEdgeFromNode(int index, Function && function) const
+{
+    const auto iter = m_edgesFromNode.find(index);
+    if (iter != m_edgesFromNode.end())
+    {
+        for (auto && edge : iter->second)
+        {
+            function(*edge);
+        }
+    }
+}
+
+template<typename Function>
+void Graph::forEachEdgeToNode(int index, Function && function) const
+{
+    const auto iter = m_edgesToNode.find(index);
+    if (iter != m_edgesToNode.end())
+    {
+        for (auto && edge : iter->second)
+        {
+            function(*edge);
+        }
+    }
+}
+
+template<typename Function>
+void Graph::forEachNode(Function && function) const
+{
+    const auto & locations = m_nodeStore.locations();
+    const auto & sizes = m_nodeStore.sizes();
+    const auto & colors = m_nodeStore.colors();
+    for (size_t position = 0; position < m_nodes.size(); position++)
+    {
+        function(static_cast<int>(position), locations[position], sizes[position], colors[position], m_nodes[position]->text());
+    }
+}
+
+template<typename Function>
+void Graph::forEachEdgeFromPosition(int position, Function && function) const
+{
+    forEachEdgeFromNode(m_nodes[position]->index(), [&] (EdgeBase & edge) {
+        function(m_nodeStore.slot(edge.targetNodeBase()), edge.text());
+    });
+}
+
+template<typename Function>
+void Graph::forEachNodeConnectedToNode(int index, Function && function) const
+{
+    forEachEdgeToNode(index, [&] (EdgeBase & edge) {
+        function(edge.sourceNodeBase());
+    });
+
+    forEachEdgeFromNode(index, [&] (EdgeBase & edge) {
+        function(edge.targetNodeBase());
+    });
+}
+
 #endif // GRAPH_HPP
@@ -14,9 +14,13 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "graphicsfactory.hpp"
+#include "edge.hpp"
+#include "node.hpp"
 
 #include <QGraphicsDropShadowEffect>
 
+#include <memory>
+
 QGraphicsEffect * GraphicsFactory::createDropShadowEffect()
 {
     QGraphicsDropShadowEffect * shadow = new QGraphicsDropShadowEffect();
@@ -24,3 +28,15 @@ QGraphicsEffect * GraphicsFactory::createDropShadowEffect()
     shadow->setBlurRadius(5);
     return shadow;
 }
+
+MindMapDataPtr GraphicsFactory::copyMindMapData(const MindMapData & mindMapData)
+{
+    return std::make_shared<MindMapData>(mindMapData,
+        [] (const NodeBase & node) {
+            return std::make_shared<Node>(node);
+        },
+        [] (NodeBase & sourceNode, NodeBase & targetNode) {
+            // The nodes have been created by the node factory above
+            return std::make_shared<Edge>(static_cast<Node &>(sourceNode), static_cast<Node &>(targetNode));
+        });
+}
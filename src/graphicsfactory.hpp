@@ -16,10 +16,15 @@
 #ifndef GRAPHICSFACTORY_HPP
 #define GRAPHICSFACTORY_HPP
 
+#include "mindmapdata.hpp"
+
 class QGraphicsEffect;
 
 namespace GraphicsFactory {
 QGraphicsEffect * createDropShadowEffect();
+
+//! Copies the mind map so that its nodes and edges are graphics items that can be added to the scene.
+MindMapDataPtr copyMindMapData(const MindMapData & mindMapData);
 }
 
 #endif // GRAPHICSFACTORY_HPP
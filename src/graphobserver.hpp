@@ -0,0 +1,64 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GRAPHOBSERVER_HPP
+#define GRAPHOBSERVER_HPP
+
+#include <memory>
+#include <vector>
+
+class EdgeBase;
+class NodeBase;
+
+//! Interface for receiving change notifications from a Graph.
+//! Notifications are sent after the graph has been updated.
+class GraphObserver
+{
+public:
+
+    virtual ~GraphObserver() {}
+
+    virtual void nodeAdded(NodeBase &) {}
+
+    virtual void nodeRemoved(NodeBase &) {}
+
+    //! Called when color, location, size, index or text of a node has changed.
+    virtual void nodeChanged(NodeBase &) {}
+
+    virtual void edgeAdded(EdgeBase &) {}
+
+    virtual void edgeRemoved(EdgeBase &) {}
+
+    //! Called when text of an edge has changed.
+    virtual void edgeChanged(EdgeBase &) {}
+
+    //! Called once after Graph::build() has added the given nodes and edges.
+    //! The default implementation forwards each item to nodeAdded() and edgeAdded().
+    virtual void nodesAndEdgesAdded(const std::vector<std::shared_ptr<NodeBase>> & nodes, const std::vector<std::shared_ptr<EdgeBase>> & edges)
+    {
+        for (auto && node : nodes)
+        {
+            nodeAdded(*node);
+        }
+
+        for (auto && edge : edges)
+        {
+            edgeAdded(*edge);
+        }
+    }
+};
+
+#endif // GRAPHOBSERVER_HPP
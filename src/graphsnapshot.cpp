@@ -0,0 +1,107 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "graphsnapshot.hpp"
+#include "graph.hpp"
+
+GraphSnapshot::GraphSnapshot(const Graph & graph)
+{
+    const auto & nodes = graph.getNodes();
+    const auto & store = graph.nodeStore();
+
+    // The store is already in node order so the attribute arrays can be copied as such
+    m_indices = store.indices();
+    m_locations = store.locations();
+    m_sizes = store.sizes();
+    m_colors = store.colors();
+
+    m_texts.reserve(nodes.size());
+    m_positions.reserve(nodes.size());
+    for (auto && node : nodes)
+    {
+        m_positions[node->index()] = static_cast<int>(m_texts.size());
+        m_texts.push_back(node->text());
+    }
+
+    m_edgeOffsets.reserve(nodes.size() + 1);
+    m_edgeTargets.reserve(graph.getEdges().size());
+    m_edgeTexts.reserve(graph.getEdges().size());
+
+    m_edgeOffsets.push_back(0);
+    for (auto && node : nodes)
+    {
+        graph.forEachEdgeFromNode(node->index(), [&] (EdgeBase & edge) {
+            m_edgeTargets.push_back(m_positions[edge.targetNodeBase().index()]);
+            m_edgeTexts.push_back(edge.text());
+        });
+        m_edgeOffsets.push_back(static_cast<int>(m_edgeTargets.size()));
+    }
+}
+
+int GraphSnapshot::numNodes() const
+{
+    return static_cast<int>(m_indices.size());
+}
+
+int GraphSnapshot::numEdges() const
+{
+    return static_cast<int>(m_edgeTargets.size());
+}
+
+int GraphSnapshot::position(int index) const
+{
+    const auto iter = m_positions.find(index);
+    return iter != m_positions.end() ? iter->second : -1;
+}
+
+const std::vector<int> & GraphSnapshot::indices() const
+{
+    return m_indices;
+}
+
+const std::vector<QPointF> & GraphSnapshot::locations() const
+{
+    return m_locations;
+}
+
+const std::vector<QSizeF> & GraphSnapshot::sizes() const
+{
+    return m_sizes;
+}
+
+const std::vector<QColor> & GraphSnapshot::colors() const
+{
+    return m_colors;
+}
+
+const std::vector<QString> & GraphSnapshot::texts() const
+{
+    return m_texts;
+}
+
+const std::vector<int> & GraphSnapshot::edgeOffsets() const
+{
+    return m_edgeOffsets;
+}
+
+const std::vector<int> & GraphSnapshot::edgeTargets() const
+{
+    return m_edgeTargets;
+}
+
+const std::vector<QString> & GraphSnapshot::edgeTexts() const
+{
+    return m_edgeTexts;
+}
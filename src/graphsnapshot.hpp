@@ -0,0 +1,123 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GRAPHSNAPSHOT_HPP
+#define GRAPHSNAPSHOT_HPP
+
+#include <QColor>
+#include <QPointF>
+#include <QSizeF>
+#include <QString>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class Graph;
+
+/*! Immutable read-only copy of a Graph in compressed sparse row form.
+ *
+ *  Node attributes are stored in parallel arrays addressed by node position
+ *  0..numNodes() - 1, which follows the order of Graph::getNodes(). The edges
+ *  from the node at position p are edgeTargets()[edgeOffsets()[p]..edgeOffsets()[p + 1] - 1].
+ *
+ *  The snapshot doesn't refer to the original graph in any way so it can be
+ *  handed to worker threads while the graph is being edited. */
+class GraphSnapshot
+{
+public:
+
+    explicit GraphSnapshot(const Graph & graph);
+
+    GraphSnapshot(const GraphSnapshot & other) = delete;
+
+    GraphSnapshot & operator= (const GraphSnapshot & other) = delete;
+
+    int numNodes() const;
+
+    int numEdges() const;
+
+    //! \return position of the node of given index or -1 if not found.
+    int position(int index) const;
+
+    const std::vector<int> & indices() const;
+
+    const std::vector<QPointF> & locations() const;
+
+    const std::vector<QSizeF> & sizes() const;
+
+    const std::vector<QColor> & colors() const;
+
+    const std::vector<QString> & texts() const;
+
+    //! Edge offsets per source node position. Has numNodes() + 1 elements.
+    const std::vector<int> & edgeOffsets() const;
+
+    //! Target node positions of the edges.
+    const std::vector<int> & edgeTargets() const;
+
+    const std::vector<QString> & edgeTexts() const;
+
+    //! Calls function(int position, const QPointF & location, const QSizeF & size, const QColor & color, const QString & text)
+    //! for each node in position order.
+    template<typename Function>
+    void forEachNode(Function && function) const;
+
+    //! Calls function(int targetPosition, const QString & text) for each edge from the node at given position.
+    template<typename Function>
+    void forEachEdgeFromPosition(int position, Function && function) const;
+
+private:
+
+    std::vector<int> m_indices;
+
+    std::vector<QPointF> m_locations;
+
+    std::vector<QSizeF> m_sizes;
+
+    std::vector<QColor> m_colors;
+
+    std::vector<QString> m_texts;
+
+    std::vector<int> m_edgeOffsets;
+
+    std::vector<int> m_edgeTargets;
+
+    std::vector<QString> m_edgeTexts;
+
+    std::unordered_map<int, int> m_positions;
+};
+
+template<typename Function>
+void GraphSnapshot::forEachNode(Function && function) const
+{
+    for (int position = 0; position < numNodes(); position++)
+    {
+        function(position, m_locations[position], m_sizes[position], m_colors[position], m_texts[position]);
+    }
+}
+
+template<typename Function>
+void GraphSnapshot::forEachEdgeFromPosition(int position, Function && function) const
+{
+    for (int edge = m_edgeOffsets[position]; edge < m_edgeOffsets[position + 1]; edge++)
+    {
+        function(m_edgeTargets[edge], m_edgeTexts[edge]);
+    }
+}
+
+using GraphSnapshotPtr = std::shared_ptr<const GraphSnapshot>;
+
+#endif // GRAPHSNAPSHOT_HPP
@@ -32,6 +32,7 @@
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QScreen>
 #include <QSettings>
 #include <QStandardPaths>
@@ -46,6 +47,8 @@ MainWindow * MainWindow::m_instance = nullptr;
 
 static const QString FILE_EXTENSION(Config::FILE_EXTENSION);
 
+static const QString BINARY_FILE_EXTENSION(Config::BINARY_FILE_EXTENSION);
+
 MainWindow::MainWindow(QString mindMapFile)
 : m_aboutDlg(new AboutDlg(this))
 , m_exportToPNGDialog(new ExportToPNGDialog(this))
@@ -70,10 +73,16 @@ MainWindow::MainWindow(QString mindMapFile)
     {
         QTimer::singleShot(0, this, SLOT(openArgMindMap()));
     }
+    else
+    {
+        QTimer::singleShot(0, this, SLOT(offerAutosaveRecovery()));
+    }
 
     connect(m_exportToPNGDialog, &ExportToPNGDialog::pngExportRequested, m_mediator, &Mediator::exportToPNG);
 
     connect(m_mediator, &Mediator::exportFinished, m_exportToPNGDialog, &ExportToPNGDialog::finishExport);
+
+    connect(m_mediator, &Mediator::openMindMapFinished, this, &MainWindow::finishOpenMindMap);
 }
 
 void MainWindow::addRedoAction(QMenu & menu)
@@ -153,6 +162,39 @@ void MainWindow::createFileMenu()
         runState(m_stateMachine->calculateState(StateMachine::Action::SaveAsSelected, *m_mediator));
     });
 
+    // Add "save incrementally"-option. Saves only append to a journal next to the file when enabled.
+    const auto saveIncrementallyAction = new QAction(tr("Save &Incrementally"), this);
+    saveIncrementallyAction->setCheckable(true);
+    saveIncrementallyAction->setChecked(loadBoolSetting("saveIncrementally"));
+    m_mediator->setJournalingEnabled(saveIncrementallyAction->isChecked());
+    fileMenu->addAction(saveIncrementallyAction);
+    connect(saveIncrementallyAction, &QAction::toggled, [=] (bool checked) {
+        m_mediator->setJournalingEnabled(checked);
+        saveBoolSetting("saveIncrementally", checked);
+    });
+
+    // Add "compress saved files"-option. Files that are already compressed stay compressed anyway.
+    const auto compressAction = new QAction(tr("&Compress Saved Files"), this);
+    compressAction->setCheckable(true);
+    compressAction->setChecked(loadBoolSetting("compressSavedFiles"));
+    m_mediator->setCompressionEnabled(compressAction->isChecked());
+    fileMenu->addAction(compressAction);
+    connect(compressAction, &QAction::toggled, [=] (bool checked) {
+        m_mediator->setCompressionEnabled(checked);
+        saveBoolSetting("compressSavedFiles", checked);
+    });
+
+    // Add "compact file format"-option. Older versions of Heimer cannot read such files.
+    const auto compactFileFormatAction = new QAction(tr("Compact &File Format"), this);
+    compactFileFormatAction->setCheckable(true);
+    compactFileFormatAction->setChecked(loadBoolSetting("compactFileFormat"));
+    m_mediator->setCompactFileFormatEnabled(compactFileFormatAction->isChecked());
+    fileMenu->addAction(compactFileFormatAction);
+    connect(compactFileFormatAction, &QAction::toggled, [=] (bool checked) {
+        m_mediator->setCompactFileFormatEnabled(checked);
+        saveBoolSetting("compactFileFormat", checked);
+    });
+
     // Add "export to PNG image"-action
     const auto exportToPNGAction = new QAction(tr("&Export to PNG image..."), this);
     exportToPNGAction->setShortcut(QKeySequence("Ctrl+Shift+E"));
@@ -220,7 +262,7 @@ void MainWindow::showExportToPNGDialog()
 
 QString MainWindow::getFileDialogFileText() const
 {
-    return tr("Heimer Files") + " (*" + FILE_EXTENSION + ")";
+    return tr("Heimer Files") + " (*" + FILE_EXTENSION + " *" + BINARY_FILE_EXTENSION + ")";
 }
 
 void MainWindow::init()
@@ -293,6 +335,31 @@ void MainWindow::openArgMindMap()
     doOpenMindMap(m_argMindMapFile);
 }
 
+void MainWindow::offerAutosaveRecovery()
+{
+    // The editor may have crashed or been killed before a new mind map was saved
+    const auto autosaves = m_mediator->orphanedAutosaveFileNames();
+    if (autosaves.isEmpty())
+    {
+        return;
+    }
+
+    const auto autosave = autosaves.first();
+    if (QMessageBox::question(this, tr("Recover Autosave"),
+        tr("There are unsaved changes in a new mind map from an earlier session. Do you want to recover them?"),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes) == QMessageBox::Yes)
+    {
+        MCLogger().debug() << "Recovering '" << autosave.toStdString() << "'";
+
+        showOpenProgressDialog(tr("Recovering.."));
+        m_mediator->recoverUntitledMindMap(autosave);
+    }
+    else
+    {
+        m_mediator->discardOrphanedAutosave(autosave);
+    }
+}
+
 void MainWindow::openMindMap()
 {
     MCLogger().debug() << "Open file";
@@ -337,6 +404,15 @@ QString MainWindow::loadRecentPath() const
     return path;
 }
 
+bool MainWindow::loadBoolSetting(QString key) const
+{
+    QSettings settings;
+    settings.beginGroup(m_settingsGroup);
+    const auto value = settings.value(key, false).toBool();
+    settings.endGroup();
+    return value;
+}
+
 void MainWindow::showAboutDlg()
 {
     m_aboutDlg->exec();
@@ -351,13 +427,37 @@ void MainWindow::doOpenMindMap(QString fileName)
 {
     MCLogger().debug() << "Opening '" << fileName.toStdString();
 
-    if (m_mediator->openMindMap(fileName))
+    showOpenProgressDialog(tr("Opening '") + fileName + "'..");
+
+    // The editor may have crashed or been killed before the changes were saved
+    bool recoverAutosave = false;
+    if (m_mediator->hasNewerAutosave(fileName))
+    {
+        recoverAutosave = QMessageBox::question(this, tr("Recover Autosave"),
+            tr("There are unsaved changes in '") + fileName + tr("' from an earlier session. Do you want to recover them?"),
+            QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes) == QMessageBox::Yes;
+    }
+
+    m_mediator->openMindMap(fileName, recoverAutosave);
+}
+
+void MainWindow::finishOpenMindMap(bool success)
+{
+    if (success)
     {
         disableUndoAndRedo();
 
-        saveRecentPath(fileName);
+        // A recovered new mind map has no file yet
+        if (m_mediator->fileName().isEmpty())
+        {
+            setSaveActionStatesOnNewMindMap();
+        }
+        else
+        {
+            saveRecentPath(m_mediator->fileName());
 
-        setSaveActionStatesOnOpenedMindMap();
+            setSaveActionStatesOnOpenedMindMap();
+        }
 
         runState(m_stateMachine->calculateState(StateMachine::Action::MindMapOpened, *m_mediator));
     }
@@ -371,6 +471,14 @@ void MainWindow::saveRecentPath(QString fileName)
     settings.endGroup();
 }
 
+void MainWindow::saveBoolSetting(QString key, bool value)
+{
+    QSettings settings;
+    settings.beginGroup(m_settingsGroup);
+    settings.setValue(key, value);
+    settings.endGroup();
+}
+
 void MainWindow::saveWindowSize()
 {
     QSettings settings;
@@ -417,7 +525,7 @@ void MainWindow::saveMindMapAs()
         return;
     }
 
-    if (!fileName.endsWith(FILE_EXTENSION))
+    if (!fileName.endsWith(FILE_EXTENSION) && !fileName.endsWith(BINARY_FILE_EXTENSION))
     {
         fileName += FILE_EXTENSION;
     }
@@ -437,6 +545,17 @@ void MainWindow::saveMindMapAs()
     }
 }
 
+void MainWindow::showOpenProgressDialog(QString labelText)
+{
+    // The dialog shows up only if the loading takes a while
+    const auto progressDialog = new QProgressDialog(labelText, tr("Cancel"), 0, 100, this);
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setMinimumDuration(500);
+    connect(m_mediator, &Mediator::openMindMapProgressChanged, progressDialog, &QProgressDialog::setValue);
+    connect(m_mediator, &Mediator::openMindMapFinished, progressDialog, &QObject::deleteLater);
+    connect(progressDialog, &QProgressDialog::canceled, m_mediator, &Mediator::cancelOpenMindMap);
+}
+
 void MainWindow::showErrorDialog(QString message)
 {
     QMessageBox::critical(this,
@@ -480,7 +599,8 @@ void MainWindow::setSaveActionStatesOnNewMindMap()
 
 void MainWindow::setSaveActionStatesOnOpenedMindMap()
 {
-    m_saveAction->setEnabled(false);
+    // A recovered autosave is modified
+    m_saveAction->setEnabled(m_mediator->isModified());
     m_saveAsAction->setEnabled(true);
 }
 
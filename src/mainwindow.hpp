@@ -79,6 +79,8 @@ private slots:
 
     void doOpenMindMap(QString fileName);
 
+    void finishOpenMindMap(bool success);
+
     void initializeNewMindMap();
 
     void saveMindMap();
@@ -93,6 +95,8 @@ private slots:
 
     void showExportToPNGDialog();
 
+    void offerAutosaveRecovery();
+
     void openArgMindMap();
 
     void openMindMap();
@@ -117,12 +121,17 @@ private:
 
     void init();
 
+    //! \return the boolean setting of the main window, false by default.
+    bool loadBoolSetting(QString key) const;
+
     QString loadRecentPath() const;
 
     void populateMenuBar();
 
     void runState(StateMachine::State state);
 
+    void saveBoolSetting(QString key, bool value);
+
     void saveRecentPath(QString fileName);
 
     void saveWindowSize();
@@ -131,6 +140,8 @@ private:
 
     void setSaveActionStatesOnOpenedMindMap();
 
+    void showOpenProgressDialog(QString labelText);
+
     AboutDlg * m_aboutDlg;
 
     ExportToPNGDialog * m_exportToPNGDialog;
@@ -0,0 +1,154 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "mapcache.hpp"
+#include "binaryserializer.hpp"
+#include "config.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+
+constexpr const char * MapCache::MAGIC;
+
+constexpr quint32 MapCache::VERSION;
+
+static const auto ENTRY_EXTENSION = ".cache";
+
+MapCache::MapCache(QString directory)
+    : m_directory(directory)
+{
+}
+
+QString MapCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/maps";
+}
+
+MapCache::Key MapCache::key(QString filePath)
+{
+    Key key;
+    key.filePath = QFileInfo(filePath).absoluteFilePath();
+
+    QFile file(filePath);
+    if (file.open(QIODevice::ReadOnly))
+    {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        if (hash.addData(&file))
+        {
+            const QFileInfo fileInfo(file);
+            key.size = fileInfo.size();
+            key.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+            key.hash = hash.result();
+        }
+    }
+
+    return key;
+}
+
+QString MapCache::directory() const
+{
+    return m_directory;
+}
+
+MindMapDataPtr MapCache::read(const Key & key) const
+{
+    if (key.hash.isEmpty())
+    {
+        return MindMapDataPtr();
+    }
+
+    QFile file(entryFileName(key.filePath));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return MindMapDataPtr();
+    }
+
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    char magic[4] = {};
+    quint32 version = 0;
+    qint64 size = 0;
+    qint64 modified = 0;
+    QByteArray hash(key.hash.size(), Qt::Uninitialized);
+    in.readRawData(magic, 4);
+    in >> version >> size >> modified;
+    in.readRawData(hash.data(), hash.size());
+
+    if (in.status() != QDataStream::Ok || std::memcmp(magic, MAGIC, 4) || version != VERSION ||
+        size != key.size || modified != key.modified || hash != key.hash)
+    {
+        return MindMapDataPtr();
+    }
+
+    return BinarySerializer::fromBinary(file, file.pos());
+}
+
+bool MapCache::write(const Key & key, MindMapData & mindMapData) const
+{
+    if (key.hash.isEmpty() || !QDir().mkpath(m_directory))
+    {
+        return false;
+    }
+
+    // Readers see either the old or the new entry as a whole
+    QSaveFile file(entryFileName(key.filePath));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData(MAGIC, 4);
+    out << VERSION << key.size << key.modified;
+    out.writeRawData(key.hash.constData(), key.hash.size());
+
+    if (out.status() != QDataStream::Ok || !BinarySerializer::toBinary(mindMapData, file))
+    {
+        file.cancelWriting();
+    }
+
+    const bool written = file.commit();
+
+    removeOldEntries();
+
+    return written;
+}
+
+QString MapCache::entryFileName(QString filePath) const
+{
+    // Paths may contain characters that are not allowed in file names
+    const auto name = QCryptographicHash::hash(filePath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_directory + "/" + QString::fromLatin1(name) + ENTRY_EXTENSION;
+}
+
+void MapCache::removeOldEntries() const
+{
+    const auto entries = QDir(m_directory).entryInfoList({QString("*") + ENTRY_EXTENSION}, QDir::Files, QDir::Time);
+    for (int i = Config::MAP_CACHE_MAX_ENTRIES; i < entries.size(); i++)
+    {
+        QFile::remove(entries.at(i).absoluteFilePath());
+    }
+}
@@ -0,0 +1,79 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef MAPCACHE_HPP
+#define MAPCACHE_HPP
+
+#include <QByteArray>
+#include <QString>
+
+#include "mindmapdata.hpp"
+
+/*! Cache of parsed mind maps in the binary format of BinaryMapView.
+ *
+ *  There's one entry per mind map file path. An entry starts with MAGIC, VERSION and the Key it
+ *  was created for, followed by the binary map. The entry is used only if the size, modification
+ *  time and content hash of the file still match. The least recently written entries are removed
+ *  when there are more than Config::MAP_CACHE_MAX_ENTRIES.
+ *
+ *  All methods can be called from any thread. */
+class MapCache
+{
+public:
+
+    static constexpr auto MAGIC = "HMRC";
+
+    static constexpr quint32 VERSION = 1;
+
+    //! Identifies the content of a mind map file.
+    struct Key
+    {
+        QString filePath;
+
+        qint64 size = 0;
+
+        qint64 modified = 0;
+
+        //! SHA-1 of the file content. Empty if the file couldn't be read.
+        QByteArray hash;
+    };
+
+    explicit MapCache(QString directory = defaultDirectory());
+
+    //! \return the directory of the cache under the user's cache location, e.g. ~/.cache/Heimer/maps.
+    static QString defaultDirectory();
+
+    //! Reads the whole file to compute the content hash.
+    static Key key(QString filePath);
+
+    QString directory() const;
+
+    //! \return the cached mind map or nullptr if there's no entry that matches the key.
+    MindMapDataPtr read(const Key & key) const;
+
+    //! Replaces the entry of the file path of the key. \return false on failure.
+    bool write(const Key & key, MindMapData & mindMapData) const;
+
+private:
+
+    QString entryFileName(QString filePath) const;
+
+    void removeOldEntries() const;
+
+    QString m_directory;
+};
+
+#endif // MAPCACHE_HPP
@@ -27,6 +27,7 @@
 #include <QGraphicsScene>
 #include <QSizePolicy>
 
+#include <algorithm>
 #include <cassert>
 
 using std::dynamic_pointer_cast;
@@ -54,6 +55,21 @@ Mediator::Mediator(MainWindow & mainWindow)
         m_mainWindow.enableSave(isModified && canBeSaved());
     });
 
+    connect(m_editorData, &EditorData::loadProgressChanged, this, &Mediator::openMindMapProgressChanged);
+
+    connect(m_editorData, &EditorData::mindMapLoaded, [=] () {
+        initializeOpenedMindMap();
+        emit openMindMapFinished(true);
+    });
+
+    connect(m_editorData, &EditorData::mindMapLoadFailed, [=] (QString errorMessage) {
+        if (!errorMessage.isEmpty())
+        {
+            m_mainWindow.showErrorDialog(errorMessage);
+        }
+        emit openMindMapFinished(false);
+    });
+
     connect(&m_mainWindow, &MainWindow::zoomToFitTriggered, this, &Mediator::zoomToFit);
     connect(&m_mainWindow, &MainWindow::zoomInTriggered, this, &Mediator::zoomIn);
     connect(&m_mainWindow, &MainWindow::zoomOutTriggered, this, &Mediator::zoomOut);
@@ -63,31 +79,25 @@ Mediator::Mediator(MainWindow & mainWindow)
 
 void Mediator::addExistingGraphToScene()
 {
-    for (auto && node : m_editorData->mindMapData()->graph().getNodes())
+    for (auto && node : m_pendingNodes)
     {
-        if (dynamic_pointer_cast<QGraphicsItem>(node)->scene() != m_editorScene)
-        {
-            addItem(*dynamic_pointer_cast<Node>(node));
-            MCLogger().debug() << "Added an existing node " << node->index() << " to scene";
-        }
+        addItem(*node);
+        MCLogger().debug() << "Added an existing node " << node->index() << " to scene";
     }
 
-    for (auto && edge : m_editorData->mindMapData()->graph().getEdges())
+    for (auto && edge : m_pendingEdges)
     {
-        auto node0 = dynamic_pointer_cast<Node>(getNodeByIndex(edge->sourceNodeBase().index()));
-        auto node1 = dynamic_pointer_cast<Node>(getNodeByIndex(edge->targetNodeBase().index()));
-
-        if (!m_editorScene->hasEdge(*node0, *node1))
-        {
-            auto graphicsEdge = dynamic_pointer_cast<Edge>(edge);
-            assert(graphicsEdge);
-            addItem(*graphicsEdge);
-            node0->addGraphicsEdge(*graphicsEdge);
-            node1->addGraphicsEdge(*graphicsEdge);
-            graphicsEdge->updateLine();
-            MCLogger().debug() << "Added an existing edge " << node0->index() << " -> " << node1->index() << " to scene";
-        }
+        auto && node0 = edge->sourceNode();
+        auto && node1 = edge->targetNode();
+        addItem(*edge);
+        node0.addGraphicsEdge(*edge);
+        node1.addGraphicsEdge(*edge);
+        edge->updateLine();
+        MCLogger().debug() << "Added an existing edge " << node0.index() << " -> " << node1.index() << " to scene";
     }
+
+    m_pendingNodes.clear();
+    m_pendingEdges.clear();
 }
 
 void Mediator::addItem(QGraphicsItem & item)
@@ -172,15 +182,22 @@ void Mediator::deleteNode(Node & node)
 
     if (isInBetween(node))
     {
-        auto && nodes = graph.getNodesConnectedToNode(graph.getNode(node.index()));
-        assert(nodes.size() == 2);
-        const auto node0 = nodes.at(0);
-        const auto node1 = nodes.at(1);
-        if (!graph.areDirectlyConnected(node0, node1))
+        Node * nodes[2] = {};
+        int count = 0;
+        graph.forEachNodeConnectedToNode(node.index(), [&] (NodeBase & connectedNode) {
+            if (count < 2)
+            {
+                nodes[count] = dynamic_cast<Node *>(&connectedNode);
+            }
+            count++;
+        });
+        assert(count == 2 && nodes[0] && nodes[1]);
+        auto && node0 = *nodes[0];
+        auto && node1 = *nodes[1];
+        if (!graph.areDirectlyConnected(graph.getNode(node0.index()), graph.getNode(node1.index())))
         {
-            connectEdgeToUndoMechanism(m_editorData->addEdge(
-                std::make_shared<Edge>(*dynamic_pointer_cast<Node>(node0), *dynamic_pointer_cast<Node>(node1))));
-            MCLogger().debug() << "Created a new edge " << node0->index() << " -> " << node1->index();
+            connectEdgeToUndoMechanism(m_editorData->addEdge(std::make_shared<Edge>(node0, node1)));
+            MCLogger().debug() << "Created a new edge " << node0.index() << " -> " << node1.index();
 
             addExistingGraphToScene();
         }
@@ -189,6 +206,18 @@ void Mediator::deleteNode(Node & node)
     graph.deleteNode(node.index());
 }
 
+void Mediator::edgeAdded(EdgeBase & edge)
+{
+    auto graphicsEdge = dynamic_cast<Edge *>(&edge);
+    assert(graphicsEdge);
+    m_pendingEdges.push_back(graphicsEdge);
+}
+
+void Mediator::edgeRemoved(EdgeBase & edge)
+{
+    m_pendingEdges.erase(std::remove(m_pendingEdges.begin(), m_pendingEdges.end(), &edge), m_pendingEdges.end());
+}
+
 void Mediator::enableUndo(bool enable)
 {
     m_mainWindow.enableUndo(enable);
@@ -223,11 +252,33 @@ NodeBasePtr Mediator::getNodeByIndex(int index)
     return m_editorData->getNodeByIndex(index);
 }
 
+bool Mediator::hasNewerAutosave(QString fileName) const
+{
+    return EditorData::hasNewerAutosave(fileName);
+}
+
 bool Mediator::hasNodes() const
 {
     return m_editorData->mindMapData() && m_editorData->mindMapData()->graph().numNodes();
 }
 
+void Mediator::discardOrphanedAutosave(QString autosaveFileName)
+{
+    EditorData::discardOrphanedAutosave(autosaveFileName);
+}
+
+QStringList Mediator::orphanedAutosaveFileNames() const
+{
+    return EditorData::orphanedAutosaveFileNames();
+}
+
+void Mediator::recoverUntitledMindMap(QString autosaveFileName)
+{
+    assert(m_editorData);
+
+    m_editorData->recoverUntitledMindMapDataInBackground(autosaveFileName);
+}
+
 void Mediator::initializeNewMindMap()
 {
     MCLogger().debug() << "Initializing a new mind map";
@@ -236,6 +287,8 @@ void Mediator::initializeNewMindMap()
 
     m_editorData->setMindMapData(std::make_shared<MindMapData>());
 
+    observeGraph();
+
     delete m_editorScene;
     m_editorScene = new EditorScene;
 
@@ -268,13 +321,52 @@ void Mediator::initializeView()
 bool Mediator::isLeafNode(Node & node)
 {
     auto && graph = m_editorData->mindMapData()->graph();
-    return graph.getEdgesFromNode(graph.getNode(node.index())).size() + graph.getEdgesToNode(graph.getNode(node.index())).size() == 1;
+    return graph.numEdgesFromNode(node.index()) + graph.numEdgesToNode(node.index()) == 1;
 }
 
 bool Mediator::isInBetween(Node & node)
 {
     auto && graph = m_editorData->mindMapData()->graph();
-    return graph.getEdgesFromNode(graph.getNode(node.index())).size() + graph.getEdgesToNode(graph.getNode(node.index())).size() == 2;
+    return graph.numEdgesFromNode(node.index()) + graph.numEdgesToNode(node.index()) == 2;
+}
+
+void Mediator::nodeAdded(NodeBase & node)
+{
+    auto graphicsNode = dynamic_cast<Node *>(&node);
+    assert(graphicsNode);
+    m_pendingNodes.push_back(graphicsNode);
+}
+
+void Mediator::nodeRemoved(NodeBase & node)
+{
+    m_pendingNodes.erase(std::remove(m_pendingNodes.begin(), m_pendingNodes.end(), &node), m_pendingNodes.end());
+}
+
+void Mediator::observeGraph()
+{
+    if (auto observedMindMapData = m_observedMindMapData.lock())
+    {
+        observedMindMapData->graph().removeObserver(*this);
+    }
+
+    m_pendingNodes.clear();
+    m_pendingEdges.clear();
+
+    m_observedMindMapData = m_editorData->mindMapData();
+    if (auto mindMapData = m_editorData->mindMapData())
+    {
+        for (auto && node : mindMapData->graph().getNodes())
+        {
+            nodeAdded(*node);
+        }
+
+        for (auto && edge : mindMapData->graph().getEdges())
+        {
+            edgeAdded(*edge);
+        }
+
+        mindMapData->graph().addObserver(*this);
+    }
 }
 
 bool Mediator::isRedoable() const
@@ -292,32 +384,41 @@ bool Mediator::isUndoable() const
     return m_editorData->isUndoable();
 }
 
-bool Mediator::openMindMap(QString fileName)
+void Mediator::openMindMap(QString fileName, bool recoverAutosave)
 {
     assert(m_editorData);
 
-    try
+    if (recoverAutosave)
     {
-        delete m_editorScene;
-        m_editorScene = new EditorScene;
+        m_editorData->recoverMindMapDataInBackground(fileName);
+    }
+    else
+    {
+        m_editorData->loadMindMapDataInBackground(fileName);
+    }
+}
 
-        m_editorData->loadMindMapData(fileName);
+void Mediator::cancelOpenMindMap()
+{
+    assert(m_editorData);
 
-        initializeView();
+    m_editorData->cancelLoading();
+}
 
-        addExistingGraphToScene();
+void Mediator::initializeOpenedMindMap()
+{
+    delete m_editorScene;
+    m_editorScene = new EditorScene;
 
-        connectGraphToUndoMechanism();
+    observeGraph();
 
-        zoomToFit();
-    }
-    catch (const FileException & e)
-    {
-        m_mainWindow.showErrorDialog(e.message());
-        return false;
-    }
+    initializeView();
+
+    addExistingGraphToScene();
+
+    connectGraphToUndoMechanism();
 
-    return true;
+    zoomToFit();
 }
 
 void Mediator::redo()
@@ -360,6 +461,21 @@ Node * Mediator::selectedNode() const
     return m_editorData->selectedNode();
 }
 
+void Mediator::setCompactFileFormatEnabled(bool enabled)
+{
+    m_editorData->setCompactFileFormatEnabled(enabled);
+}
+
+void Mediator::setCompressionEnabled(bool enabled)
+{
+    m_editorData->setCompressionEnabled(enabled);
+}
+
+void Mediator::setJournalingEnabled(bool enabled)
+{
+    m_editorData->setJournalingEnabled(enabled);
+}
+
 void Mediator::setSelectedNode(Node * node)
 {
     m_editorData->setSelectedNode(node);
@@ -374,6 +490,8 @@ void Mediator::setupMindMapAfterUndoOrRedo()
 
     m_editorView->setBackgroundBrush(QBrush(m_editorData->backgroundColor()));
 
+    observeGraph();
+
     addExistingGraphToScene();
 
     connectGraphToUndoMechanism();
@@ -404,16 +522,24 @@ void Mediator::zoomOut()
 QSize Mediator::zoomForExport()
 {
     m_editorScene->clearSelection();
-    m_editorScene->setSceneRect(m_editorScene->getNodeBoundingRectWithHeuristics());
+    m_editorScene->setSceneRect(m_editorScene->getNodeBoundingRectWithHeuristics(m_editorData->mindMapData()->graph().nodeStore()));
     return m_editorScene->sceneRect().size().toSize();
 }
 
 void Mediator::zoomToFit()
 {
-    m_editorView->zoomToFit(m_editorScene->getNodeBoundingRectWithHeuristics());
+    if (m_editorData->mindMapData())
+    {
+        m_editorView->zoomToFit(m_editorScene->getNodeBoundingRectWithHeuristics(m_editorData->mindMapData()->graph().nodeStore()));
+    }
 }
 
 Mediator::~Mediator()
 {
+    if (auto observedMindMapData = m_observedMindMapData.lock())
+    {
+        observedMindMapData->graph().removeObserver(*this);
+    }
+
     delete m_editorData;
 }
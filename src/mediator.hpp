@@ -19,7 +19,12 @@
 #include <QObject>
 #include <QPointF>
 #include <QString>
+#include <QStringList>
 
+#include <memory>
+#include <vector>
+
+#include "graphobserver.hpp"
 #include "node.hpp"
 
 class DragAndDropStore;
@@ -27,6 +32,7 @@ class EditorData;
 class EditorScene;
 class EditorView;
 class MainWindow;
+class MindMapData;
 class QGraphicsItem;
 
 /*! Acts as a communication channel between MainWindow and editor components:
@@ -34,7 +40,7 @@ class QGraphicsItem;
  *  - MainWindow <-> Mediator <-> QGraphicsScene / EditorView / EditorData
  *  - EditorView <-> Mediator <-> EditorData
  */
-class Mediator : public QObject
+class Mediator : public QObject, private GraphObserver
 {
     Q_OBJECT
 
@@ -62,12 +68,18 @@ public:
 
     void deleteNode(Node & node);
 
+    //! Removes an autosave of orphanedAutosaveFileNames() whose changes are not wanted.
+    void discardOrphanedAutosave(QString autosaveFileName);
+
     void enableUndo(bool enable);
 
     QString fileName() const;
 
     NodeBasePtr getNodeByIndex(int index);
 
+    //! \return true if the mind map file has an autosave that is newer than the file, e.g. after a crash.
+    bool hasNewerAutosave(QString fileName) const;
+
     bool hasNodes() const;
 
     void initializeNewMindMap();
@@ -82,10 +94,18 @@ public:
 
     bool isModified() const;
 
-    bool openMindMap(QString fileName);
+    /*! Loads the mind map in the background. Emits openMindMapProgressChanged() and finally openMindMapFinished().
+     *  If recoverAutosave is true the content is loaded from the autosave of the file instead. */
+    void openMindMap(QString fileName, bool recoverAutosave = false);
+
+    //! \return autosaves of new mind maps from earlier sessions, e.g. after a crash. The newest comes first.
+    QStringList orphanedAutosaveFileNames() const;
 
     void redo();
 
+    //! Loads an autosave of orphanedAutosaveFileNames() like openMindMap(). The result is a new, modified mind map.
+    void recoverUntitledMindMap(QString autosaveFileName);
+
     void removeItem(QGraphicsItem & item);
 
     bool saveMindMapAs(QString fileName);
@@ -96,6 +116,12 @@ public:
 
     Node * selectedNode() const;
 
+    void setCompactFileFormatEnabled(bool enabled);
+
+    void setCompressionEnabled(bool enabled);
+
+    void setJournalingEnabled(bool enabled);
+
     void setSelectedNode(Node * node);
 
     void setupMindMapAfterUndoOrRedo();
@@ -104,6 +130,8 @@ public:
 
 public slots:
 
+    void cancelOpenMindMap();
+
     void exportToPNG(QString filename, QSize size, bool transparentBackground);
 
     void saveUndoPoint();
@@ -122,14 +150,39 @@ signals:
 
     void exportFinished();
 
+    void openMindMapProgressChanged(int percent);
+
+    void openMindMapFinished(bool success);
+
 private:
 
+    //! Adds nodes and edges that have been added to the graph since the last call to the scene.
     void addExistingGraphToScene();
 
     void connectGraphToUndoMechanism();
 
     void initializeView();
 
+    //! Sets up the scene for the mind map that has just been loaded.
+    void initializeOpenedMindMap();
+
+    //! Starts tracking the graph of the current mind map. All of its nodes and edges are queued for the scene.
+    void observeGraph();
+
+    void edgeAdded(EdgeBase & edge) override;
+
+    void edgeRemoved(EdgeBase & edge) override;
+
+    void nodeAdded(NodeBase & node) override;
+
+    void nodeRemoved(NodeBase & node) override;
+
+    std::weak_ptr<MindMapData> m_observedMindMapData;
+
+    std::vector<Edge *> m_pendingEdges;
+
+    std::vector<Node *> m_pendingNodes;
+
     EditorData * m_editorData;
 
     EditorScene * m_editorScene;
@@ -15,43 +15,70 @@
 
 #include "mindmapdata.hpp"
 
-#include "node.hpp"
+#include "edgebase.hpp"
+#include "nodebase.hpp"
 
 #include <memory>
+#include <unordered_map>
 
 MindMapData::MindMapData(QString name)
     : MindMapDataBase(name)
 {}
 
+static NodeBasePtr copyNode(const NodeBase & other)
+{
+    auto node = std::make_shared<NodeBase>();
+    node->setColor(other.color());
+    node->setIndex(other.index());
+    node->setLocation(other.location());
+    node->setSize(other.size());
+    node->setText(other.text());
+    return node;
+}
+
 MindMapData::MindMapData(const MindMapData & other)
+    : MindMapData(other, copyNode,
+          [] (NodeBase & sourceNode, NodeBase & targetNode) { return std::make_shared<EdgeBase>(sourceNode, targetNode); })
+{
+}
+
+MindMapData::MindMapData(const MindMapData & other, const NodeFactory & nodeFactory, const EdgeFactory & edgeFactory)
     : MindMapDataBase(other)
     , m_fileName(other.m_fileName)
     , m_version(other.m_version)
     , m_backgroundColor(other.m_backgroundColor)
 {
-    copyGraph(other);
+    copyGraph(other, nodeFactory, edgeFactory);
 }
 
-void MindMapData::copyGraph(const MindMapData & other)
+void MindMapData::copyGraph(const MindMapData & other, const NodeFactory & nodeFactory, const EdgeFactory & edgeFactory)
 {
     m_graph.clear();
 
-    // Use copy constructor for nodes
+    // Create nodes with the attributes of the source nodes, which can be of any NodeBase type
+    Graph::NodeVector nodes;
+    nodes.reserve(other.m_graph.getNodes().size());
+    std::unordered_map<const NodeBase *, NodeBase *> copiedNodes;
+    copiedNodes.reserve(other.m_graph.getNodes().size());
     for (auto && nodeBase : other.m_graph.getNodes())
     {
-        m_graph.addNode(std::make_shared<Node>(*std::dynamic_pointer_cast<Node>(nodeBase)));
+        auto node = nodeFactory(*nodeBase);
+        copiedNodes[nodeBase.get()] = node.get();
+        nodes.push_back(node);
     }
 
-    // Create new edges
+    // Create new edges between the copied nodes
+    Graph::EdgeVector edges;
+    edges.reserve(other.m_graph.getEdges().size());
     for (auto && edgeBase : other.m_graph.getEdges())
     {
-        auto sourceNode = std::dynamic_pointer_cast<Node>(m_graph.getNode(edgeBase->sourceNodeBase().index()));
-        auto targetNode = std::dynamic_pointer_cast<Node>(m_graph.getNode(edgeBase->targetNodeBase().index()));
-
-        auto edge = std::make_shared<Edge>(*sourceNode, *targetNode);
+        auto edge = edgeFactory(
+            *copiedNodes.at(&edgeBase->sourceNodeBase()), *copiedNodes.at(&edgeBase->targetNodeBase()));
         edge->setText(edgeBase->text());
-        m_graph.addEdge(edge);
+        edges.push_back(edge);
     }
+
+    m_graph.build(nodes, edges);
 }
 
 QColor MindMapData::backgroundColor() const
@@ -18,6 +18,8 @@
 
 #include <QString>
 
+#include <functional>
+
 #include "config.hpp"
 #include "mindmapdatabase.hpp"
 #include "graph.hpp"
@@ -28,10 +30,20 @@ class MindMapData : public MindMapDataBase
 {
 public:
 
+    //! Creates a node with the attributes of the given node.
+    using NodeFactory = std::function<NodeBasePtr (const NodeBase & node)>;
+
+    //! Creates an edge between the given nodes, which have been created by the NodeFactory.
+    using EdgeFactory = std::function<EdgeBasePtr (NodeBase & sourceNode, NodeBase & targetNode)>;
+
     MindMapData(QString name = "");
 
+    //! Copies the graph as plain NodeBase and EdgeBase objects.
     MindMapData(const MindMapData & other);
 
+    //! Copies the graph as the nodes and edges created by the given factories, e.g. graphics items.
+    MindMapData(const MindMapData & other, const NodeFactory & nodeFactory, const EdgeFactory & edgeFactory);
+
     virtual ~MindMapData();
 
     QColor backgroundColor() const;
@@ -52,7 +64,7 @@ public:
 
 private:
 
-    void copyGraph(const MindMapData & other);
+    void copyGraph(const MindMapData & other, const NodeFactory & nodeFactory, const EdgeFactory & edgeFactory);
 
     QString m_fileName;
 
@@ -0,0 +1,78 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "mindmaploader.hpp"
+#include "reader.hpp"
+
+MindMapLoader::MindMapLoader(QString fileName, const MapCache & cache, QObject * parent)
+    : QThread(parent)
+    , m_fileName(fileName)
+    , m_cache(cache)
+    , m_isCanceled(false)
+{
+}
+
+void MindMapLoader::cancel()
+{
+    m_isCanceled = true;
+}
+
+bool MindMapLoader::isCanceled() const
+{
+    return m_isCanceled;
+}
+
+QString MindMapLoader::errorMessage() const
+{
+    return m_errorMessage;
+}
+
+QString MindMapLoader::fileName() const
+{
+    return m_fileName;
+}
+
+MindMapDataPtr MindMapLoader::mindMapData() const
+{
+    return m_mindMapData;
+}
+
+void MindMapLoader::run()
+{
+    int lastPercent = -1;
+    try
+    {
+        m_mindMapData = Reader::readFromFile(m_fileName, [this, &lastPercent] (int percent) {
+            // The signal is queued to the GUI thread so don't flood it
+            if (percent != lastPercent)
+            {
+                lastPercent = percent;
+                emit progressChanged(percent);
+            }
+
+            return !m_isCanceled;
+        }, &m_cache);
+    }
+    catch (const FileException & e)
+    {
+        m_errorMessage = e.message();
+    }
+
+    if (m_isCanceled)
+    {
+        m_mindMapData.reset();
+    }
+}
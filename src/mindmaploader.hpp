@@ -0,0 +1,73 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef MINDMAPLOADER_HPP
+#define MINDMAPLOADER_HPP
+
+#include <QString>
+#include <QThread>
+
+#include <atomic>
+
+#include "mapcache.hpp"
+#include "mindmapdata.hpp"
+
+/*! Reads a mind map file in a thread of its own.
+ *
+ *  The result is a plain model without graphics items, see Reader::readFromFile().
+ *  It's available after QThread::finished() has been emitted. */
+class MindMapLoader : public QThread
+{
+    Q_OBJECT
+
+public:
+
+    MindMapLoader(QString fileName, const MapCache & cache, QObject * parent = nullptr);
+
+    //! Requests the loading to stop. Can be called from any thread.
+    void cancel();
+
+    bool isCanceled() const;
+
+    QString errorMessage() const;
+
+    QString fileName() const;
+
+    //! \return the loaded mind map or nullptr if the loading failed or was canceled.
+    MindMapDataPtr mindMapData() const;
+
+signals:
+
+    void progressChanged(int percent);
+
+protected:
+
+    virtual void run() override;
+
+private:
+
+    const QString m_fileName;
+
+    const MapCache m_cache;
+
+    std::atomic<bool> m_isCanceled;
+
+    QString m_errorMessage;
+
+    MindMapDataPtr m_mindMapData;
+};
+
+#endif // MINDMAPLOADER_HPP
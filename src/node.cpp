@@ -50,7 +50,8 @@ Node::Node()
 
     connect(m_textEdit, &TextEdit::textChanged, [=] (const QString & text) {
 
-        setText(text);
+        // The text edit already holds the new text, so only the stored text and the graph need updating
+        NodeBase::setText(text);
 
         if (isTextUnderflowOrOverflow())
         {
@@ -62,6 +63,11 @@ Node::Node()
 }
 
 Node::Node(const Node & other)
+    : Node(static_cast<const NodeBase &>(other))
+{
+}
+
+Node::Node(const NodeBase & other)
     : Node()
 {
     setColor(other.color());
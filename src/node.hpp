@@ -42,6 +42,9 @@ public:
     //! Copy constructor.
     Node(const Node & other);
 
+    //! Creates a graphics node with the attributes of a plain node, e.g. one decoded on a worker thread.
+    explicit Node(const NodeBase & other);
+
     virtual ~Node();
 
     virtual void addGraphicsEdge(Edge & edge);
@@ -14,6 +14,9 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "nodebase.hpp"
+#include "nodestore.hpp"
+
+#include <cassert>
 
 NodeBase::NodeBase()
 {
@@ -21,31 +24,49 @@ NodeBase::NodeBase()
 
 QSizeF NodeBase::size() const
 {
-    return m_size;
+    return m_store ? m_store->m_sizes[m_slot] : m_size;
 }
 
 void NodeBase::setSize(QSizeF size)
 {
-    m_size = size;
+    if (m_store)
+    {
+        m_store->m_sizes[m_slot] = size;
+        m_store->notifyChanged(*this);
+    }
+    else
+    {
+        m_size = size;
+    }
 }
 
 QPointF NodeBase::location() const
 {
-    return m_location;
+    return m_store ? m_store->m_locations[m_slot] : m_location;
 }
 
 void NodeBase::setLocation(QPointF newLocation)
 {
-    m_location = newLocation;
+    if (m_store)
+    {
+        m_store->m_locations[m_slot] = newLocation;
+        m_store->notifyChanged(*this);
+    }
+    else
+    {
+        m_location = newLocation;
+    }
 }
 
 int NodeBase::index() const
 {
-    return m_index;
+    return m_store ? m_store->m_indices[m_slot] : m_index;
 }
 
 void NodeBase::setIndex(int index)
 {
+    // The graph keys its lookups by the index, see Graph::compact()
+    assert(!m_store);
     m_index = index;
 }
 
@@ -57,18 +78,32 @@ QString NodeBase::text() const
 void NodeBase::setText(const QString & text)
 {
     m_text = text;
+
+    if (m_store)
+    {
+        m_store->notifyChanged(*this);
+    }
 }
 
 QColor NodeBase::color() const
 {
-    return m_color;
+    return m_store ? m_store->m_colors[m_slot] : m_color;
 }
 
 void NodeBase::setColor(const QColor & color)
 {
-    m_color = color;
+    if (m_store)
+    {
+        m_store->m_colors[m_slot] = color;
+        m_store->notifyChanged(*this);
+    }
+    else
+    {
+        m_color = color;
+    }
 }
 
 NodeBase::~NodeBase()
 {
+    assert(!m_store);
 }
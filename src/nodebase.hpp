@@ -24,7 +24,12 @@
 #include <memory>
 #include <vector>
 
-//! Base class for freely placeable target nodes in the editor.
+class NodeStore;
+
+/*! Base class for freely placeable target nodes in the editor.
+ *
+ *  When the node belongs to a Graph its color, location, size and index
+ *  live in the graph's NodeStore and the node acts as a handle to them. */
 class NodeBase
 {
 public:
@@ -53,6 +58,7 @@ public:
 
     virtual int index() const;
 
+    //! Only for nodes that are not in a graph. Graph::compact() renumbers the nodes of a graph.
     virtual void setIndex(int index);
 
     virtual QString text() const;
@@ -61,6 +67,14 @@ public:
 
 private:
 
+    friend class NodeStore;
+
+    NodeStore * m_store = nullptr;
+
+    int m_slot = -1;
+
+    // These are used only while the node is not attached to a NodeStore
+
     QColor m_color = Qt::white;
 
     QPointF m_location;
@@ -0,0 +1,177 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "nodestore.hpp"
+#include "graph.hpp"
+#include "nodebase.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+NodeStore::NodeStore(Graph & graph)
+    : m_graph(graph)
+{
+}
+
+void NodeStore::attach(NodeBase & node)
+{
+    assert(!node.m_store);
+
+    m_owners.push_back(&node);
+    m_colors.push_back(node.m_color);
+    m_indices.push_back(node.m_index);
+    m_locations.push_back(node.m_location);
+    m_sizes.push_back(node.m_size);
+
+    node.m_store = this;
+    node.m_slot = static_cast<int>(m_owners.size()) - 1;
+}
+
+void NodeStore::detachSlot(int slot)
+{
+    auto && node = *m_owners.at(slot);
+    node.m_color = m_colors.at(slot);
+    node.m_index = m_indices.at(slot);
+    node.m_location = m_locations.at(slot);
+    node.m_size = m_sizes.at(slot);
+    node.m_store = nullptr;
+    node.m_slot = -1;
+}
+
+void NodeStore::detach(const std::unordered_set<int> & indices)
+{
+    // Stable compaction of all arrays so that the order stays in sync with the graph
+    size_t kept = 0;
+    for (size_t slot = 0; slot < m_owners.size(); slot++)
+    {
+        if (indices.count(m_indices[slot]))
+        {
+            detachSlot(static_cast<int>(slot));
+        }
+        else
+        {
+            if (kept != slot)
+            {
+                m_owners[kept] = m_owners[slot];
+                m_colors[kept] = m_colors[slot];
+                m_indices[kept] = m_indices[slot];
+                m_locations[kept] = m_locations[slot];
+                m_sizes[kept] = m_sizes[slot];
+                m_owners[kept]->m_slot = static_cast<int>(kept);
+            }
+            kept++;
+        }
+    }
+
+    m_owners.resize(kept);
+    m_colors.resize(kept);
+    m_indices.resize(kept);
+    m_locations.resize(kept);
+    m_sizes.resize(kept);
+}
+
+void NodeStore::clear()
+{
+    for (size_t slot = 0; slot < m_owners.size(); slot++)
+    {
+        detachSlot(static_cast<int>(slot));
+    }
+
+    m_owners.clear();
+    m_colors.clear();
+    m_indices.clear();
+    m_locations.clear();
+    m_sizes.clear();
+}
+
+void NodeStore::notifyChanged(NodeBase & node)
+{
+    m_graph.notifyNodeChanged(node);
+}
+
+void NodeStore::reserve(size_t nodes)
+{
+    m_owners.reserve(nodes);
+    m_colors.reserve(nodes);
+    m_indices.reserve(nodes);
+    m_locations.reserve(nodes);
+    m_sizes.reserve(nodes);
+}
+
+void NodeStore::renumber()
+{
+    for (size_t slot = 0; slot < m_indices.size(); slot++)
+    {
+        m_indices[slot] = static_cast<int>(slot);
+    }
+}
+
+int NodeStore::size() const
+{
+    return static_cast<int>(m_owners.size());
+}
+
+int NodeStore::slot(const NodeBase & node) const
+{
+    return node.m_store == this ? node.m_slot : -1;
+}
+
+QRectF NodeStore::boundingRect() const
+{
+    if (m_locations.empty())
+    {
+        return QRectF();
+    }
+
+    qreal left = m_locations[0].x() - m_sizes[0].width() / 2;
+    qreal right = m_locations[0].x() + m_sizes[0].width() / 2;
+    qreal top = m_locations[0].y() - m_sizes[0].height() / 2;
+    qreal bottom = m_locations[0].y() + m_sizes[0].height() / 2;
+    for (size_t slot = 1; slot < m_locations.size(); slot++)
+    {
+        left = std::min(left, m_locations[slot].x() - m_sizes[slot].width() / 2);
+        right = std::max(right, m_locations[slot].x() + m_sizes[slot].width() / 2);
+        top = std::min(top, m_locations[slot].y() - m_sizes[slot].height() / 2);
+        bottom = std::max(bottom, m_locations[slot].y() + m_sizes[slot].height() / 2);
+    }
+
+    return QRectF(left, top, right - left, bottom - top);
+}
+
+const std::vector<QColor> & NodeStore::colors() const
+{
+    return m_colors;
+}
+
+const std::vector<int> & NodeStore::indices() const
+{
+    return m_indices;
+}
+
+const std::vector<QPointF> & NodeStore::locations() const
+{
+    return m_locations;
+}
+
+const std::vector<QSizeF> & NodeStore::sizes() const
+{
+    return m_sizes;
+}
+
+NodeStore::~NodeStore()
+{
+    clear();
+}
@@ -0,0 +1,100 @@
+// This file is part of Heimer.
+// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef NODESTORE_HPP
+#define NODESTORE_HPP
+
+#include <QColor>
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+
+#include <cstddef>
+#include <unordered_set>
+#include <vector>
+
+class Graph;
+class NodeBase;
+
+/*! Structure-of-arrays storage for the attributes of the nodes in a Graph.
+ *
+ *  Locations, sizes, colors and indices are kept in parallel contiguous arrays
+ *  and NodeBase acts as a handle into them while it's attached. The arrays follow
+ *  the order of Graph::getNodes() so whole-graph passes can loop over them directly. */
+class NodeStore
+{
+public:
+
+    explicit NodeStore(Graph & graph);
+
+    NodeStore(const NodeStore & other) = delete;
+
+    NodeStore & operator= (const NodeStore & other) = delete;
+
+    ~NodeStore();
+
+    //! Moves the attributes of the node into the store. The node must not belong to a store already.
+    void attach(NodeBase & node);
+
+    //! Detaches the nodes of given indices in a single pass. The nodes get their attributes back.
+    void detach(const std::unordered_set<int> & indices);
+
+    //! Detaches all nodes.
+    void clear();
+
+    void reserve(size_t nodes);
+
+    //! Sets the indices to 0..size() - 1 in node order without notifying the graph.
+    void renumber();
+
+    int size() const;
+
+    //! \return slot of the node in the store, which is its position in Graph::getNodes(), or -1 if not attached.
+    int slot(const NodeBase & node) const;
+
+    //! \return the union of the node rectangles centered at the node locations.
+    QRectF boundingRect() const;
+
+    const std::vector<QColor> & colors() const;
+
+    const std::vector<int> & indices() const;
+
+    const std::vector<QPointF> & locations() const;
+
+    const std::vector<QSizeF> & sizes() const;
+
+private:
+
+    friend class NodeBase;
+
+    void detachSlot(int slot);
+
+    void notifyChanged(NodeBase & node);
+
+    Graph & m_graph;
+
+    std::vector<NodeBase *> m_owners;
+
+    std::vector<QColor> m_colors;
+
+    std::vector<int> m_indices;
+
+    std::vector<QPointF> m_locations;
+
+    std::vector<QSizeF> m_sizes;
+};
+
+#endif // NODESTORE_HPP
@@ -14,28 +14,92 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "reader.hpp"
+#include "binarymapview.hpp"
+#include "binaryserializer.hpp"
+#include "changejournal.hpp"
+#include "compresseddevice.hpp"
+#include "mapcache.hpp"
+#include "serializer.hpp"
 
 #include <QFile>
 #include <QObject>
 
-QDomDocument Reader::readFromFile(QString filePath)
+#include <algorithm>
+
+static MindMapDataPtr readCompressed(QFile & file, const Serializer::ProgressCallback & progress)
 {
-    QDomDocument doc;
+    // Decompress chunk by chunk while parsing
+    CompressedDevice device(file);
+    return device.open(QIODevice::ReadOnly) ? Serializer::fromXml(device, progress) : MindMapDataPtr();
+}
 
+MindMapDataPtr Reader::readFromFile(QString filePath, ProgressCallback progress, const MapCache * cache)
+{
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly))
     {
         throw FileException(QObject::tr("Cannot open file: '") + filePath + "'");
     }
 
-    if (!doc.setContent(&file))
+    // The position in the file is a good enough estimate for all formats
+    bool canceled = false;
+    const auto reportPosition = [&] (qint64 position) {
+        canceled = canceled || (progress && !progress(static_cast<int>(position * 100 / std::max<qint64>(file.size(), 1))));
+        return !canceled;
+    };
+    const auto reportProgress = [&] () {
+        return reportPosition(file.pos());
+    };
+
+    // Detect the format from the content so that renamed files still open
+    MindMapDataPtr data;
+    const auto magic = file.peek(4);
+    if (BinaryMapView::hasMagic(reinterpret_cast<const uchar *>(magic.constData()), magic.size()))
     {
-        file.close();
+        // Decoding is fast enough to be done in one go
+        if (reportProgress())
+        {
+            data = BinarySerializer::fromBinary(file);
+        }
+    }
+    else
+    {
+        // Parsing XML is slow, so reuse the model parsed from the same content earlier
+        MapCache::Key key;
+        if (cache)
+        {
+            key = MapCache::key(filePath);
+            data = cache->read(key);
+        }
 
-        throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+        if (!data)
+        {
+            // Plain XML is parsed from memory so that large maps can be split across threads
+            data = CompressedDevice::hasMagic(magic) ? readCompressed(file, reportProgress) : Serializer::fromXml(file.readAll(), reportPosition);
+            if (data && cache)
+            {
+                cache->write(key, *data);
+            }
+        }
     }
 
     file.close();
 
-    return doc;
+    if (canceled)
+    {
+        return MindMapDataPtr();
+    }
+
+    if (!data)
+    {
+        throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+    }
+
+    // Number the nodes like they were when the file was saved. Files of older versions may have holes.
+    data->graph().compact();
+
+    // Bring in the changes saved incrementally since the file was last written in full
+    ChangeJournal::replay(filePath, *data);
+
+    return data;
 }
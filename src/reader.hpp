@@ -16,13 +16,26 @@
 #ifndef READER_HPP
 #define READER_HPP
 
-#include <QDomDocument>
+#include <QString>
+
+#include <functional>
 
 #include "fileexception.hpp"
+#include "mindmapdata.hpp"
+
+class MapCache;
 
 namespace Reader {
 
-    QDomDocument readFromFile(QString filePath);
+    //! Receives the percentage of the file read so far. Returning false cancels the reading.
+    using ProgressCallback = std::function<bool (int percent)>;
+
+    /*! Reads the mind map from the given XML, compressed XML or binary file and applies its ChangeJournal,
+     *  if any. Can be called from any thread as the graph consists of plain NodeBase and EdgeBase objects.
+     *  XML files are looked up from the given cache first and added to it after parsing.
+     *  Throws FileException on failure.
+     *  \return nullptr if the reading was canceled. */
+    MindMapDataPtr readFromFile(QString filePath, ProgressCallback progress = ProgressCallback(), const MapCache * cache = nullptr);
 
 }
 
@@ -15,258 +15,882 @@
 
 #include "serializer.hpp"
 #include "config.hpp"
+#include "edgebase.hpp"
 #include "graph.hpp"
-#include "node.hpp"
+#include "graphsnapshot.hpp"
+#include "nodebase.hpp"
 #include "mclogger.hh"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <functional>
-#include <map>
+#include <limits>
+#include <unordered_map>
+#include <vector>
 
+#include <QBuffer>
+#include <QHash>
 #include <QDomElement>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 static const double SCALE = 1000; // https://bugreports.qt.io/browse/QTBUG-67129
 
 using std::make_shared;
 
-static void writeNodes(MindMapData & mindMapData, QDomElement & root, QDomDocument & doc)
+using NodeIndexMap = std::unordered_map<int, NodeBasePtr>;
+
+static void writeColorElement(QXmlStreamWriter & writer, const char * name, QColor color)
+{
+    writer.writeStartElement(name);
+    writer.writeAttribute(Serializer::DataKeywords::Design::Color::R, QString::number(color.red()));
+    writer.writeAttribute(Serializer::DataKeywords::Design::Color::G, QString::number(color.green()));
+    writer.writeAttribute(Serializer::DataKeywords::Design::Color::B, QString::number(color.blue()));
+    writer.writeEndElement();
+}
+
+//! Ids of the node colors, node texts and edge texts of a graph in Serializer::Format::Tables.
+//! Empty texts get no id, i.e. -1.
+struct TableIds
+{
+    std::vector<int> nodeColors;
+
+    std::vector<int> nodeTexts;
+
+    std::vector<int> edgeTexts;
+};
+
+// The writers below take either a live Graph or a GraphSnapshot, which have the same interface for this.
+
+template<typename Source>
+static TableIds writeTables(const Source & source, QXmlStreamWriter & writer)
+{
+    TableIds ids;
+
+    writer.writeStartElement(Serializer::DataKeywords::Design::PALETTE);
+    std::unordered_map<QRgb, int> colorIds;
+    ids.nodeColors.reserve(source.numNodes());
+    source.forEachNode([&] (int, const QPointF &, const QSizeF &, const QColor & color, const QString &) {
+        const auto result = colorIds.emplace(color.rgb(), static_cast<int>(colorIds.size()));
+        if (result.second)
+        {
+            writeColorElement(writer, Serializer::DataKeywords::Design::COLOR, color);
+        }
+
+        ids.nodeColors.push_back(result.first->second);
+    });
+    writer.writeEndElement();
+
+    writer.writeStartElement(Serializer::DataKeywords::Design::STRINGS);
+    QHash<QString, int> textIds;
+    const auto textId = [&] (const QString & text) {
+        if (text.isEmpty())
+        {
+            return -1;
+        }
+
+        auto iter = textIds.find(text);
+        if (iter == textIds.end())
+        {
+            iter = textIds.insert(text, textIds.size());
+            writer.writeTextElement(Serializer::DataKeywords::Design::Graph::Node::TEXT, text);
+        }
+
+        return iter.value();
+    };
+
+    ids.nodeTexts.reserve(source.numNodes());
+    source.forEachNode([&] (int, const QPointF &, const QSizeF &, const QColor &, const QString & text) {
+        ids.nodeTexts.push_back(textId(text));
+    });
+
+    // Edge texts in the same order as the edges are written
+    ids.edgeTexts.reserve(source.numEdges());
+    for (int position = 0; position < source.numNodes(); position++)
+    {
+        source.forEachEdgeFromPosition(position, [&] (int, const QString & text) {
+            ids.edgeTexts.push_back(textId(text));
+        });
+    }
+    writer.writeEndElement();
+
+    return ids;
+}
+
+template<typename Source>
+static void writeNodes(const Source & source, QXmlStreamWriter & writer, const TableIds * ids)
+{
+    // Nodes are numbered by their position so that the holes left by deleted nodes are not saved
+    source.forEachNode([&] (int position, const QPointF & location, const QSizeF & size, const QColor & color, const QString & text) {
+        writer.writeStartElement(Serializer::DataKeywords::Design::Graph::NODE);
+        writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Node::INDEX, QString::number(position));
+        writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Node::X, QString::number(static_cast<int>(location.x() * SCALE)));
+        writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Node::Y, QString::number(static_cast<int>(location.y() * SCALE)));
+        writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Node::W, QString::number(static_cast<int>(size.width() * SCALE)));
+        writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Node::H, QString::number(static_cast<int>(size.height() * SCALE)));
+
+        if (ids)
+        {
+            writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Node::COLOR_ID, QString::number(ids->nodeColors[position]));
+            if (ids->nodeTexts[position] >= 0)
+            {
+                writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Node::TEXT_ID, QString::number(ids->nodeTexts[position]));
+            }
+        }
+        else
+        {
+            // Create a child element for the text content
+            writer.writeTextElement(Serializer::DataKeywords::Design::Graph::Node::TEXT, text);
+
+            // Create a child element for color
+            writeColorElement(writer, Serializer::DataKeywords::Design::Graph::Node::COLOR, color);
+        }
+
+        writer.writeEndElement();
+    });
+}
+
+template<typename Source>
+static void writeEdges(const Source & source, QXmlStreamWriter & writer, const TableIds * ids)
+{
+    // The edges are grouped by source node in node order and keep their insertion order,
+    // so the output stays stable and the pass is linear in graph size.
+    int edge = 0;
+    for (int position = 0; position < source.numNodes(); position++)
+    {
+        source.forEachEdgeFromPosition(position, [&] (int target, const QString & text) {
+            writer.writeStartElement(Serializer::DataKeywords::Design::Graph::EDGE);
+            writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Edge::INDEX0, QString::number(position));
+            writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Edge::INDEX1, QString::number(target));
+
+            if (ids)
+            {
+                if (ids->edgeTexts[edge] >= 0)
+                {
+                    writer.writeAttribute(Serializer::DataKeywords::Design::Graph::Edge::TEXT_ID, QString::number(ids->edgeTexts[edge]));
+                }
+            }
+            else
+            {
+                // Create a child element for the text content
+                writer.writeTextElement(Serializer::DataKeywords::Design::Graph::Node::TEXT, text);
+            }
+
+            writer.writeEndElement();
+            edge++;
+        });
+    }
+}
+
+template<typename Source>
+static bool writeDesign(const Source & source, QColor backgroundColor, QIODevice & device, Serializer::Format format)
 {
-    for (auto node : mindMapData.graph().getNodes())
+    QXmlStreamWriter writer(&device);
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(1);
+    writer.writeStartDocument();
+
+    writer.writeStartElement(Serializer::DataKeywords::Design::DESIGN);
+    writer.writeAttribute(Serializer::DataKeywords::Design::APPLICATION_VERSION, Config::APPLICATION_VERSION);
+
+    writeColorElement(writer, Serializer::DataKeywords::Design::COLOR, backgroundColor);
+
+    // The tables must precede the graph so that they can be resolved while reading it
+    TableIds ids;
+    if (format == Serializer::Format::Tables)
     {
-        auto nodeElement = doc.createElement(Serializer::DataKeywords::Design::Graph::NODE);
-        nodeElement.setAttribute(Serializer::DataKeywords::Design::Graph::Node::INDEX, node->index());
-        nodeElement.setAttribute(Serializer::DataKeywords::Design::Graph::Node::X, static_cast<int>(node->location().x() * SCALE));
-        nodeElement.setAttribute(Serializer::DataKeywords::Design::Graph::Node::Y, static_cast<int>(node->location().y() * SCALE));
-        nodeElement.setAttribute(Serializer::DataKeywords::Design::Graph::Node::W, static_cast<int>(node->size().width() * SCALE));
-        nodeElement.setAttribute(Serializer::DataKeywords::Design::Graph::Node::H, static_cast<int>(node->size().height() * SCALE));
-        root.appendChild(nodeElement);
-
-        // Create a child node for the text content
-        auto textElement = doc.createElement(Serializer::DataKeywords::Design::Graph::Node::TEXT);
-        nodeElement.appendChild(textElement);
-        auto textNode = doc.createTextNode(node->text());
-        textElement.appendChild(textNode);
-
-        // Create a child node for color
-        auto colorElement = doc.createElement(Serializer::DataKeywords::Design::Graph::Node::COLOR);
-        colorElement.setAttribute(Serializer::DataKeywords::Design::Color::R, node->color().red());
-        colorElement.setAttribute(Serializer::DataKeywords::Design::Color::G, node->color().green());
-        colorElement.setAttribute(Serializer::DataKeywords::Design::Color::B, node->color().blue());
-        nodeElement.appendChild(colorElement);
+        ids = writeTables(source, writer);
     }
+
+    writer.writeStartElement(Serializer::DataKeywords::Design::GRAPH);
+    writeNodes(source, writer, format == Serializer::Format::Tables ? &ids : nullptr);
+    writeEdges(source, writer, format == Serializer::Format::Tables ? &ids : nullptr);
+    writer.writeEndElement();
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+
+    return !writer.hasError();
 }
 
-static void writeEdges(MindMapData & mindMapData, QDomElement & root, QDomDocument & doc)
+static QString readStringAttribute(const QXmlStreamAttributes & attributes, const char * name, QString defaultValue)
 {
-    for (auto node : mindMapData.graph().getNodes())
+    return attributes.hasAttribute(QLatin1String(name)) ? attributes.value(QLatin1String(name)).toString() : defaultValue;
+}
+
+//! Parses a plain decimal integer directly from the UTF-16 data without intermediate strings.
+//! \return false if the text is not such a number or doesn't fit in an int.
+static bool parseInt(const QStringRef & text, int & result)
+{
+    const auto data = text.unicode();
+    const int size = text.size();
+
+    int position = 0;
+    const bool negative = size && data[0] == QLatin1Char('-');
+    if (size && (negative || data[0] == QLatin1Char('+')))
     {
-        auto edges = mindMapData.graph().getEdgesFromNode(node);
-        for (auto && edge : edges)
+        position++;
+    }
+
+    if (position == size)
+    {
+        return false;
+    }
+
+    const qint64 limit = negative ? -static_cast<qint64>(std::numeric_limits<int>::min()) : std::numeric_limits<int>::max();
+    qint64 value = 0;
+    for (; position < size; position++)
+    {
+        const auto digit = static_cast<unsigned>(data[position].unicode()) - '0';
+        if (digit > 9)
+        {
+            return false;
+        }
+
+        value = value * 10 + digit;
+        if (value > limit)
         {
-            auto edgeElement = doc.createElement(Serializer::DataKeywords::Design::Graph::EDGE);
-            edgeElement.setAttribute(Serializer::DataKeywords::Design::Graph::Edge::INDEX0, edge->sourceNodeBase().index());
-            edgeElement.setAttribute(Serializer::DataKeywords::Design::Graph::Edge::INDEX1, edge->targetNodeBase().index());
-            root.appendChild(edgeElement);
-
-            // Create a child node for the text content
-            auto textElement = doc.createElement(Serializer::DataKeywords::Design::Graph::Node::TEXT);
-            edgeElement.appendChild(textElement);
-            auto textNode = doc.createTextNode(edge->text());
-            textElement.appendChild(textNode);
+            return false;
         }
     }
+
+    result = static_cast<int>(negative ? -value : value);
+    return true;
+}
+
+static int toInt(const QStringRef & text)
+{
+    // Fall back to the full conversion e.g. for numbers surrounded by whitespace
+    int result = 0;
+    return parseInt(text, result) ? result : text.toInt();
 }
 
-static QColor readColorElement(const QDomElement & element)
+static int readIntAttribute(const QXmlStreamAttributes & attributes, const char * name, int defaultValue)
 {
+    const auto value = attributes.value(QLatin1String(name));
+    return value.isNull() ? defaultValue : toInt(value);
+}
+
+static QColor readColorElement(QXmlStreamReader & reader)
+{
+    const auto attributes = reader.attributes();
+    reader.skipCurrentElement();
+
     return {
-        element.attribute(Serializer::DataKeywords::Design::Color::R, "255").toInt(),
-        element.attribute(Serializer::DataKeywords::Design::Color::G, "255").toInt(),
-        element.attribute(Serializer::DataKeywords::Design::Color::B, "255").toInt()
+        readIntAttribute(attributes, Serializer::DataKeywords::Design::Color::R, 255),
+        readIntAttribute(attributes, Serializer::DataKeywords::Design::Color::G, 255),
+        readIntAttribute(attributes, Serializer::DataKeywords::Design::Color::B, 255)
     };
 }
 
-static QString readFirstTextNodeContent(const QDomElement & element)
+static QString readTextElement(QXmlStreamReader & reader)
+{
+    return reader.readElementText(QXmlStreamReader::SkipChildElements);
+}
+
+static void elementWarning(const QXmlStreamReader & reader)
+{
+    MCLogger().warning() << "Unknown element '" << reader.name().toString().toStdString() << "'";
+}
+
+//! Elements known by the reader. Names are shared by different parents, e.g. color of the design and of a node.
+enum class Element
+{
+    Unknown,
+    Color,
+    Edge,
+    Graph,
+    Node,
+    Palette,
+    Strings,
+    Text
+};
+
+template<typename T>
+struct Keyword
 {
-    for (int i = 0; i < element.childNodes().count(); i++)
+    QLatin1String name;
+
+    T value;
+};
+
+template<typename T, size_t N>
+static T findKeyword(const QStringRef & name, const Keyword<T> (&keywords)[N], T unknown)
+{
+    for (auto && keyword : keywords)
     {
-        const auto child = element.childNodes().at(i);
-        if (child.isText())
+        if (name == keyword.name)
         {
-            return child.toText().nodeValue();
+            return keyword.value;
         }
     }
-    return "";
+
+    return unknown;
 }
 
-static void elementWarning(const QDomElement & element)
+// Built once so that dispatching an element only compares its name in place
+static const Keyword<Element> ELEMENTS[] = {
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::NODE), Element::Node},
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::EDGE), Element::Edge},
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::Node::TEXT), Element::Text},
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::Node::COLOR), Element::Color},
+    {QLatin1String(Serializer::DataKeywords::Design::GRAPH), Element::Graph},
+    {QLatin1String(Serializer::DataKeywords::Design::PALETTE), Element::Palette},
+    {QLatin1String(Serializer::DataKeywords::Design::STRINGS), Element::Strings},
+};
+
+static Element element(const QStringRef & name)
 {
-    MCLogger().warning() << "Unknown element '" << element.nodeName().toStdString() << "'";
+    return findKeyword(name, ELEMENTS, Element::Unknown);
+}
+
+enum class NodeAttribute
+{
+    Unknown,
+    Index,
+    X,
+    Y,
+    W,
+    H,
+    ColorId,
+    TextId
+};
+
+static const Keyword<NodeAttribute> NODE_ATTRIBUTES[] = {
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::Node::X), NodeAttribute::X},
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::Node::Y), NodeAttribute::Y},
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::Node::W), NodeAttribute::W},
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::Node::H), NodeAttribute::H},
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::Node::INDEX), NodeAttribute::Index},
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::Node::COLOR_ID), NodeAttribute::ColorId},
+    {QLatin1String(Serializer::DataKeywords::Design::Graph::Node::TEXT_ID), NodeAttribute::TextId},
+};
+
+//! Palette and string table of Serializer::Format::Tables. Empty in the inline format.
+struct Tables
+{
+    std::vector<QColor> palette;
+
+    std::vector<QString> strings;
+};
+
+//! \return the entry of given id. Invalid ids stop the parsing with an error.
+template<typename T>
+static T tableEntry(QXmlStreamReader & reader, const std::vector<T> & table, int id)
+{
+    if (id >= 0 && id < static_cast<int>(table.size()))
+    {
+        return table[id];
+    }
+
+    reader.raiseError(QString("Invalid table id: %1").arg(id));
+    return T();
 }
 
-// Generic helper that loops through element's children
-static void readChildren(const QDomElement & root, std::map<QString, std::function<void (const QDomElement &)> > handlerMap)
+// Generic helper that loops through the children of the current element.
+// The handler gets the Element of each child and must consume it up to its end tag
+// and return true, or return false to skip it as unknown.
+template<typename Handler>
+static void readChildren(QXmlStreamReader & reader, Handler && handler)
 {
-    auto domNode = root.firstChild();
-    while (!domNode.isNull())
+    while (reader.readNextStartElement())
     {
-        auto element = domNode.toElement();
-        if (!element.isNull())
+        if (!handler(element(reader.name())))
         {
-            if (handlerMap.count(element.nodeName()))
-            {
-                handlerMap[element.nodeName()](element);
-            }
-            else
-            {
-                elementWarning(element);
-            }
+            elementWarning(reader);
+            reader.skipCurrentElement();
         }
-
-        domNode = domNode.nextSibling();
     }
 }
 
-// The purpose of this #ifdef is to build GUILESS unit tests so that QTEST_GUILESS_MAIN can be used
-#ifdef HEIMER_UNIT_TEST
-static NodeBasePtr readNode(const QDomElement & element)
-#else
-static NodePtr readNode(const QDomElement & element)
-#endif
+static NodeBasePtr readNode(QXmlStreamReader & reader, const Tables & tables)
 {
-#ifdef HEIMER_UNIT_TEST
+    // Decode all attributes in a single pass directly from the reader's buffer
+    int index = -1;
+    int colorId = -1;
+    int textId = -1;
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+    bool hasW = false;
+    bool hasH = false;
+    for (auto && attribute : reader.attributes())
+    {
+        switch (findKeyword(attribute.name(), NODE_ATTRIBUTES, NodeAttribute::Unknown))
+        {
+        case NodeAttribute::Index:
+            index = toInt(attribute.value());
+            break;
+        case NodeAttribute::X:
+            x = toInt(attribute.value());
+            break;
+        case NodeAttribute::Y:
+            y = toInt(attribute.value());
+            break;
+        case NodeAttribute::W:
+            w = toInt(attribute.value());
+            hasW = true;
+            break;
+        case NodeAttribute::H:
+            h = toInt(attribute.value());
+            hasH = true;
+            break;
+        case NodeAttribute::ColorId:
+            colorId = toInt(attribute.value());
+            break;
+        case NodeAttribute::TextId:
+            textId = toInt(attribute.value());
+            break;
+        case NodeAttribute::Unknown:
+            break;
+        }
+    }
+
     auto node = make_shared<NodeBase>();
-#else
-    // Init a new node. QGraphicsScene will take the ownership eventually.
-    auto node = make_shared<Node>();
-#endif
-    node->setIndex(element.attribute(Serializer::DataKeywords::Design::Graph::Node::INDEX, "-1").toInt());
-    node->setLocation(QPointF(
-        element.attribute(Serializer::DataKeywords::Design::Graph::Node::X, "0").toInt() / SCALE,
-        element.attribute(Serializer::DataKeywords::Design::Graph::Node::Y, "0").toInt() / SCALE));
-
-    if (element.hasAttribute(Serializer::DataKeywords::Design::Graph::Node::W) &&
-        element.hasAttribute(Serializer::DataKeywords::Design::Graph::Node::H))
+    node->setIndex(index);
+    node->setLocation(QPointF(x / SCALE, y / SCALE));
+
+    if (hasW && hasH)
     {
-       node->setSize(QSizeF(
-           element.attribute(Serializer::DataKeywords::Design::Graph::Node::W).toInt() / SCALE,
-           element.attribute(Serializer::DataKeywords::Design::Graph::Node::H).toInt() / SCALE));
+        node->setSize(QSizeF(w / SCALE, h / SCALE));
     }
 
-    readChildren(element, {
-        {
-            QString(Serializer::DataKeywords::Design::Graph::Node::TEXT), [=] (const QDomElement & e) {
-                node->setText(readFirstTextNodeContent(e));
-            }
-        },
+    // The table entries are shared instead of copied
+    if (colorId != -1)
+    {
+        node->setColor(tableEntry(reader, tables.palette, colorId));
+    }
+
+    if (textId != -1)
+    {
+        node->setText(tableEntry(reader, tables.strings, textId));
+    }
+
+    readChildren(reader, [&] (Element child) {
+        switch (child)
         {
-            QString(Serializer::DataKeywords::Design::Graph::Node::COLOR), [=] (const QDomElement & e) {
-                node->setColor(readColorElement(e));
-            }
-        },
+        case Element::Text:
+            node->setText(readTextElement(reader));
+            return true;
+        case Element::Color:
+            node->setColor(readColorElement(reader));
+            return true;
+        default:
+            return false;
+        }
     });
 
     return node;
 }
 
-// The purpose of this #ifdef is to build GUILESS unit tests so that QTEST_GUILESS_MAIN can be used
-#ifdef HEIMER_UNIT_TEST
-static EdgeBasePtr readEdge(const QDomElement & element, MindMapDataPtr data)
-#else
-static EdgePtr readEdge(const QDomElement & element, MindMapDataPtr data)
-#endif
-{
-    const int index0 = element.attribute(Serializer::DataKeywords::Design::Graph::Edge::INDEX0, "-1").toInt();
-    const int index1 = element.attribute(Serializer::DataKeywords::Design::Graph::Edge::INDEX1, "-1").toInt();
-
-#ifdef HEIMER_UNIT_TEST
-    auto node0 = data->graph().getNode(index0);
-    assert(node0);
-    auto node1 = data->graph().getNode(index1);
-    assert(node1);
-    auto edge = make_shared<EdgeBase>(*node0, *node1);
-#else
-    // Init a new edge. QGraphicsScene will take the ownership eventually.
-    auto node0 = std::dynamic_pointer_cast<Node>(data->graph().getNode(index0));
-    assert(node0);
-    auto node1 = std::dynamic_pointer_cast<Node>(data->graph().getNode(index1));
-    assert(node1);
-    auto edge = make_shared<Edge>(*node0, *node1);
-#endif
-
-    readChildren(element, {
+static EdgeBasePtr readEdge(QXmlStreamReader & reader, const NodeIndexMap & nodes, const Tables & tables)
+{
+    const auto attributes = reader.attributes();
+    const int index0 = readIntAttribute(attributes, Serializer::DataKeywords::Design::Graph::Edge::INDEX0, -1);
+    const int index1 = readIntAttribute(attributes, Serializer::DataKeywords::Design::Graph::Edge::INDEX1, -1);
+
+    const auto iter0 = nodes.find(index0);
+    const auto iter1 = nodes.find(index1);
+    if (iter0 == nodes.end() || iter1 == nodes.end())
+    {
+        reader.raiseError(QString("Invalid edge: %1 -> %2").arg(index0).arg(index1));
+        return EdgeBasePtr();
+    }
+
+    auto edge = make_shared<EdgeBase>(*iter0->second, *iter1->second);
+
+    const int textId = readIntAttribute(attributes, Serializer::DataKeywords::Design::Graph::Edge::TEXT_ID, -1);
+    if (textId != -1)
+    {
+        edge->setText(tableEntry(reader, tables.strings, textId));
+    }
+
+    readChildren(reader, [&] (Element child) {
+        if (child == Element::Text)
         {
-            QString(Serializer::DataKeywords::Design::Graph::Node::TEXT), [=] (const QDomElement & e) {
-                edge->setText(readFirstTextNodeContent(e));
-            }
+            edge->setText(readTextElement(reader));
+            return true;
         }
+
+        return false;
     });
 
     return edge;
 }
 
-static void readGraph(const QDomElement & graph, MindMapDataPtr data)
+static const auto CANCELED = "Canceled";
+
+//! Error raised if the nodes cut out of the document could not be parsed in chunks.
+static const auto CHUNKS_FAILED = "Chunks failed";
+
+//! Parses the node elements cut out of the document once the tables are known. \return false on failure.
+using NodeChunkParser = std::function<bool (const Tables & tables, Graph::NodeVector & nodes)>;
+
+static void reportProgress(QXmlStreamReader & reader, const Serializer::ProgressCallback & progress)
 {
-    readChildren(graph, {
+    if (progress && !progress())
+    {
+        // Stops the parsing
+        reader.raiseError(CANCELED);
+    }
+}
+
+static void readTables(QXmlStreamReader & reader, Element table, Tables & tables)
+{
+    readChildren(reader, [&] (Element child) {
+        if (table == Element::Palette && child == Element::Color)
         {
-            QString(Serializer::DataKeywords::Design::Graph::NODE), [=] (const QDomElement & e) {
-                data->graph().addNode(readNode(e));
-            }
-        },
+            tables.palette.push_back(readColorElement(reader));
+            return true;
+        }
+
+        if (table == Element::Strings && child == Element::Text)
+        {
+            tables.strings.push_back(readTextElement(reader));
+            return true;
+        }
+
+        return false;
+    });
+}
+
+static void readGraph(QXmlStreamReader & reader, MindMapDataPtr data, const Tables & tables, const Serializer::ProgressCallback & progress,
+    const NodeChunkParser & parseNodeChunks)
+{
+    // Collect everything first so that the graph can be built in one go
+    Graph::NodeVector nodes;
+    Graph::EdgeVector edges;
+    NodeIndexMap nodesByIndex;
+
+    // The edges are linked in this final pass, so the nodes parsed in chunks come first
+    if (parseNodeChunks)
+    {
+        if (!parseNodeChunks(tables, nodes))
         {
-            QString(Serializer::DataKeywords::Design::Graph::EDGE), [=] (const QDomElement & e) {
-                data->graph().addEdge(readEdge(e, data));
+            reader.raiseError(CHUNKS_FAILED);
+            return;
+        }
+
+        nodesByIndex.reserve(nodes.size());
+        for (auto && node : nodes)
+        {
+            nodesByIndex.emplace(node->index(), node);
+        }
+    }
+
+    readChildren(reader, [&] (Element child) {
+        switch (child)
+        {
+        case Element::Node:
+        {
+            const auto node = readNode(reader, tables);
+            nodesByIndex.emplace(node->index(), node);
+            nodes.push_back(node);
+            reportProgress(reader, progress);
+            return true;
+        }
+        case Element::Edge:
+        {
+            if (const auto edge = readEdge(reader, nodesByIndex, tables))
+            {
+                edges.push_back(edge);
+                reportProgress(reader, progress);
             }
-        },
+            return true;
+        }
+        default:
+            return false;
+        }
     });
+
+    data->graph().build(nodes, edges);
 }
 
 MindMapDataPtr Serializer::fromXml(QDomDocument document)
 {
-    const auto design = document.documentElement();
-    const auto version = design.attribute(DataKeywords::Design::APPLICATION_VERSION, "UNDEFINED");
+    auto bytes = document.toByteArray();
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    return fromXml(buffer);
+}
 
+static MindMapDataPtr readDesign(QXmlStreamReader & reader, const Serializer::ProgressCallback & progress,
+    const NodeChunkParser & parseNodeChunks = NodeChunkParser())
+{
     auto data = make_shared<MindMapData>();
-    data->setVersion(version);
 
-    readChildren(design, {
-        {
-            QString(Serializer::DataKeywords::Design::GRAPH), [=] (const QDomElement & e) {
-                readGraph(e, data);
+    if (reader.readNextStartElement())
+    {
+        data->setVersion(readStringAttribute(reader.attributes(), Serializer::DataKeywords::Design::APPLICATION_VERSION, "UNDEFINED"));
+
+        Tables tables;
+        readChildren(reader, [&] (Element child) {
+            switch (child)
+            {
+            case Element::Graph:
+                readGraph(reader, data, tables, progress, parseNodeChunks);
+                return true;
+            case Element::Palette:
+            case Element::Strings:
+                readTables(reader, child, tables);
+                return true;
+            case Element::Color:
+                data->setBackgroundColor(readColorElement(reader));
+                return true;
+            default:
+                return false;
             }
-        },
+        });
+    }
+
+    return data;
+}
+
+//! \return the data read unless the reader has failed, which is logged.
+static MindMapDataPtr checkReader(const QXmlStreamReader & reader, MindMapDataPtr data)
+{
+    if (reader.hasError())
+    {
+        if (reader.error() == QXmlStreamReader::CustomError && reader.errorString() == CANCELED)
         {
-            QString(Serializer::DataKeywords::Design::COLOR), [=] (const QDomElement & e) {
-                data->setBackgroundColor(readColorElement(e));
-            }
+            MCLogger().info() << "Reading canceled";
+            return MindMapDataPtr();
         }
-    });
+
+        MCLogger().error() << "XML error on line " << reader.lineNumber() << ": " << reader.errorString().toStdString();
+        return MindMapDataPtr();
+    }
 
     return data;
 }
 
-QDomDocument Serializer::toXml(MindMapData & mindMapData)
+MindMapDataPtr Serializer::fromXml(QIODevice & device, const ProgressCallback & progress)
 {
-    QDomDocument doc;
+    QXmlStreamReader reader(&device);
+    const auto data = readDesign(reader, progress);
+    return checkReader(reader, data);
+}
+
+namespace {
+
+//! Smallest amount of node elements worth a chunk of its own.
+const int MIN_CHUNK_SIZE = 64 * 1024;
+
+//! \return position of the first start tag of given element in [from, to), or -1.
+int findStartTag(const QByteArray & xml, const char * name, int from, int to)
+{
+    const auto pattern = QByteArray("<") + name;
+    for (int position = xml.indexOf(pattern, from); position >= 0 && position < to; position = xml.indexOf(pattern, position + 1))
+    {
+        // Must not be just a prefix of another name
+        const int next = position + pattern.size();
+        if (next < xml.size() && (xml[next] == '>' || xml[next] == '/' || xml[next] == ' ' ||
+            xml[next] == '\t' || xml[next] == '\n' || xml[next] == '\r'))
+        {
+            return position;
+        }
+    }
+
+    return -1;
+}
+
+//! Parses a chunk of consecutive node elements into detached NodeBase objects.
+class NodeChunkReader : public QRunnable
+{
+public:
+
+    NodeChunkReader(const QByteArray & chunk, const Tables & tables, Graph::NodeVector & nodes,
+        std::atomic<qint64> & parsedBytes, std::atomic<bool> & failed)
+        : m_chunk(chunk)
+        , m_tables(tables)
+        , m_nodes(nodes)
+        , m_parsedBytes(parsedBytes)
+        , m_failed(failed)
+    {
+    }
+
+    virtual void run() override
+    {
+        // The chunk is only a sequence of elements, so a parent makes it a document of its own
+        QXmlStreamReader reader(QByteArray("<") + Serializer::DataKeywords::Design::GRAPH + ">" + m_chunk +
+            "</" + Serializer::DataKeywords::Design::GRAPH + ">");
+        if (reader.readNextStartElement())
+        {
+            while (!m_failed && reader.readNextStartElement())
+            {
+                if (element(reader.name()) != Element::Node)
+                {
+                    reader.raiseError(CHUNKS_FAILED);
+                    break;
+                }
+
+                m_nodes.push_back(readNode(reader, m_tables));
+            }
+        }
+
+        if (reader.hasError())
+        {
+            m_failed = true;
+        }
+
+        m_parsedBytes += m_chunk.size();
+    }
+
+private:
+
+    const QByteArray m_chunk;
+
+    const Tables & m_tables;
+
+    Graph::NodeVector & m_nodes;
 
-    auto processingInstruction = doc.createProcessingInstruction("xml", "version='1.0' encoding='UTF-8'");
-    doc.appendChild(processingInstruction);
+    std::atomic<qint64> & m_parsedBytes;
 
-    auto design = doc.createElement(Serializer::DataKeywords::Design::DESIGN);
-    design.setAttribute(Serializer::DataKeywords::Design::APPLICATION_VERSION, Config::APPLICATION_VERSION);
-    doc.appendChild(design);
+    std::atomic<bool> & m_failed;
+};
 
-    auto colorElement = doc.createElement(Serializer::DataKeywords::Design::COLOR);
-    colorElement.setAttribute(Serializer::DataKeywords::Design::Color::R, mindMapData.backgroundColor().red());
-    colorElement.setAttribute(Serializer::DataKeywords::Design::Color::G, mindMapData.backgroundColor().green());
-    colorElement.setAttribute(Serializer::DataKeywords::Design::Color::B, mindMapData.backgroundColor().blue());
-    design.appendChild(colorElement);
+//! Parses the whole document in a single pass.
+MindMapDataPtr readSerially(const QByteArray & xml, const Serializer::PositionCallback & progress)
+{
+    QBuffer buffer;
+    buffer.setData(xml);
+    buffer.open(QIODevice::ReadOnly);
+    return Serializer::fromXml(buffer, [&] () {
+        return !progress || progress(buffer.pos());
+    });
+}
 
-    auto graph = doc.createElement(Serializer::DataKeywords::Design::GRAPH);
-    design.appendChild(graph);
+} // namespace
 
-    writeNodes(mindMapData, graph, doc);
-    writeEdges(mindMapData, graph, doc);
+MindMapDataPtr Serializer::fromXml(const QByteArray & xml, const PositionCallback & progress)
+{
+    // The writer puts the node elements in a flat run at the beginning of the graph. Locate the run.
+    const int graphBegin = findStartTag(xml, DataKeywords::Design::GRAPH, 0, xml.size());
+    const int nodesBegin = graphBegin >= 0 ? findStartTag(xml, DataKeywords::Design::Graph::NODE, graphBegin, xml.size()) : -1;
+    int nodesEnd = -1;
+    if (nodesBegin >= 0)
+    {
+        const int edgesBegin = findStartTag(xml, DataKeywords::Design::Graph::EDGE, nodesBegin, xml.size());
+        const int graphEnd = xml.indexOf(QByteArray("</") + DataKeywords::Design::GRAPH, nodesBegin);
+        nodesEnd = edgesBegin >= 0 && (graphEnd < 0 || edgesBegin < graphEnd) ? edgesBegin : graphEnd;
+    }
+
+    // Anything but elements and text, e.g. a DTD, a comment or CDATA, could make a tag boundary
+    // appear where there is none. Chunks also need to be decodable without the XML declaration.
+    const int special = xml.indexOf("<!");
+    const int instruction = nodesBegin >= 0 ? xml.indexOf("<?", nodesBegin) : -1;
+    const auto declaration = xml.startsWith("<?xml") ? xml.left(xml.indexOf("?>")) : QByteArray();
+    QThreadPool pool;
+    if (nodesEnd - nodesBegin < 2 * MIN_CHUNK_SIZE || nodesBegin < 0 || pool.maxThreadCount() < 2 ||
+        (special >= 0 && special < nodesEnd) || (instruction >= 0 && instruction < nodesEnd) ||
+        (declaration.contains("encoding") && !declaration.toUpper().contains("UTF-8")))
+    {
+        return readSerially(xml, progress);
+    }
 
+    // Split the run at node tags into a few chunks per thread so that the threads stay busy
+    std::vector<QByteArray> chunks;
+    const int chunkSize = std::max(MIN_CHUNK_SIZE, (nodesEnd - nodesBegin) / (pool.maxThreadCount() * 4));
+    for (int begin = nodesBegin; begin < nodesEnd;)
+    {
+        int end = findStartTag(xml, DataKeywords::Design::Graph::NODE, begin + chunkSize, nodesEnd);
+        end = end < 0 ? nodesEnd : end;
+        chunks.push_back(QByteArray::fromRawData(xml.constData() + begin, end - begin));
+        begin = end;
+    }
+
+    // The rest of the document is read as usual and the nodes are parsed in chunks when the graph is reached
+    bool canceled = false;
+    const auto parseNodeChunks = [&] (const Tables & tables, Graph::NodeVector & nodes) {
+        std::vector<Graph::NodeVector> chunkNodes(chunks.size());
+        std::atomic<qint64> parsedBytes(0);
+        std::atomic<bool> failed(false);
+        for (size_t chunk = 0; chunk < chunks.size(); chunk++)
+        {
+            pool.start(new NodeChunkReader(chunks[chunk], tables, chunkNodes[chunk], parsedBytes, failed));
+        }
+
+        // Keep reporting progress meanwhile and once done. Canceling stops the chunks early.
+        const int progressIntervalMs = 100;
+        bool done = false;
+        while (!done)
+        {
+            done = pool.waitForDone(progressIntervalMs);
+            if (progress && !canceled && !progress(nodesBegin + parsedBytes))
+            {
+                canceled = true;
+                failed = true;
+            }
+        }
+
+        if (failed)
+        {
+            return false;
+        }
+
+        size_t numNodes = 0;
+        for (auto && chunk : chunkNodes)
+        {
+            numNodes += chunk.size();
+        }
+
+        nodes.reserve(numNodes);
+        for (auto && chunk : chunkNodes)
+        {
+            nodes.insert(nodes.end(), chunk.begin(), chunk.end());
+        }
+
+        return true;
+    };
+
+    QBuffer buffer;
+    buffer.setData(xml.left(nodesBegin) + xml.mid(nodesEnd));
+    buffer.open(QIODevice::ReadOnly);
+    QXmlStreamReader reader(&buffer);
+    const auto data = readDesign(reader, [&] () {
+        // Map the position back to the whole document
+        const auto position = buffer.pos() < nodesBegin ? buffer.pos() : buffer.pos() + nodesEnd - nodesBegin;
+        canceled = canceled || (progress && !progress(position));
+        return !canceled;
+    }, parseNodeChunks);
+
+    if (canceled)
+    {
+        MCLogger().info() << "Reading canceled";
+        return MindMapDataPtr();
+    }
+
+    // Errors are reported by the serial parser, which also copes with documents not split as expected
+    if (reader.hasError())
+    {
+        MCLogger().info() << "Cannot read in chunks: " << reader.errorString().toStdString();
+        return readSerially(xml, progress);
+    }
+
+    return data;
+}
+
+QDomDocument Serializer::toXml(MindMapData & mindMapData)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    toXml(mindMapData, buffer);
+
+    QDomDocument doc;
+    doc.setContent(buffer.data());
     return doc;
 }
+
+bool Serializer::toXml(MindMapData & mindMapData, QIODevice & device, Format format)
+{
+    // Stream from the live graph so that nothing is copied
+    return writeDesign(mindMapData.graph(), mindMapData.backgroundColor(), device, format);
+}
+
+bool Serializer::toXml(const GraphSnapshot & snapshot, QColor backgroundColor, QIODevice & device, Format format)
+{
+    return writeDesign(snapshot, backgroundColor, device, format);
+}
@@ -20,6 +20,11 @@
 
 #include <QDomDocument>
 
+#include <functional>
+
+class GraphSnapshot;
+class QIODevice;
+
 namespace Serializer {
 
     struct DataKeywords
@@ -34,6 +39,12 @@ namespace Serializer {
 
             static constexpr auto GRAPH = "graph";
 
+            //! Colors referred to by id in Format::Tables. Contains COLOR elements.
+            static constexpr auto PALETTE = "palette";
+
+            //! Texts referred to by id in Format::Tables. Contains Graph::Node::TEXT elements.
+            static constexpr auto STRINGS = "strings";
+
             // Used for Design and Node
             struct Color
             {
@@ -49,8 +60,10 @@ namespace Serializer {
                 struct Node
                 {
                     static constexpr auto COLOR = "color";
+                    static constexpr auto COLOR_ID = "c";
                     static constexpr auto INDEX = "index";
                     static constexpr auto TEXT = "text";
+                    static constexpr auto TEXT_ID = "t";
                     static constexpr auto X = "x";
                     static constexpr auto Y = "y";
                     static constexpr auto W = "w";
@@ -63,14 +76,53 @@ namespace Serializer {
                 {
                     static constexpr auto INDEX0 = "index0";
                     static constexpr auto INDEX1 = "index1";
+                    static constexpr auto TEXT_ID = "t";
                 };
             };
         };
     };
 
+    //! Revisions of the XML format. fromXml() reads all of them.
+    enum class Format
+    {
+        //! Each node and edge has its color and text as child elements. Readable by all versions.
+        Inline,
+
+        //! Distinct colors and texts are written once to a palette and a string table
+        //! and nodes and edges refer to them by id.
+        Tables
+    };
+
     MindMapDataPtr fromXml(QDomDocument document);
 
+    //! Called after each node and edge while reading. Returning false cancels the reading.
+    using ProgressCallback = std::function<bool ()>;
+
+    /*! Reads the design from the device in a single forward pass without building a DOM tree.
+     *
+     *  The graph consists of plain NodeBase and EdgeBase objects so that reading can run on any
+     *  thread. GraphicsFactory::copyMindMapData() turns them into graphics items.
+     *  \return nullptr if the content is not well-formed XML or if reading was canceled. */
+    MindMapDataPtr fromXml(QIODevice & device, const ProgressCallback & progress = ProgressCallback());
+
+    //! Called with the position in the document while reading. Returning false cancels the reading.
+    using PositionCallback = std::function<bool (qint64 position)>;
+
+    /*! Reads the design from a document in memory. The node elements of large documents are parsed
+     *  in chunks on a thread pool and the edges are linked afterwards. Falls back to a single pass
+     *  if the document is not laid out like the writer does or if a chunk cannot be parsed.
+     *  \return nullptr if the content is not well-formed XML or if reading was canceled. */
+    MindMapDataPtr fromXml(const QByteArray & xml, const PositionCallback & progress = PositionCallback());
+
     QDomDocument toXml(MindMapData & mindMapData);
+
+    /*! Writes the design to the device element by element without building a DOM tree.
+     *  Nodes are numbered densely in node order, i.e. as after Graph::compact().
+     *  \return false if writing to the device failed. */
+    bool toXml(MindMapData & mindMapData, QIODevice & device, Format format = Format::Inline);
+
+    //! Writes the design from a snapshot. Can be called from any thread.
+    bool toXml(const GraphSnapshot & snapshot, QColor backgroundColor, QIODevice & device, Format format = Format::Inline);
 }
 
 #endif // SERIALIZER_HPP
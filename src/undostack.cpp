@@ -14,6 +14,7 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "undostack.hpp"
+#include "graphicsfactory.hpp"
 
 UndoStack::UndoStack(int maxHistorySize)
     : m_maxHistorySize(maxHistorySize)
@@ -22,8 +23,7 @@ UndoStack::UndoStack(int maxHistorySize)
 
 void UndoStack::pushUndoPoint(MindMapDataPtr mindMapData)
 {
-    auto copyData = new MindMapData(*mindMapData);
-    m_undoStack.push_back(MindMapDataPtr(copyData));
+    m_undoStack.push_back(GraphicsFactory::copyMindMapData(*mindMapData));
 
     if (static_cast<int>(m_undoStack.size()) > m_maxHistorySize && m_maxHistorySize != -1)
     {
@@ -33,8 +33,7 @@ void UndoStack::pushUndoPoint(MindMapDataPtr mindMapData)
 
 void UndoStack::pushRedoPoint(MindMapDataPtr mindMapData)
 {
-    auto copyData = new MindMapData(*mindMapData);
-    m_redoStack.push_back(MindMapDataPtr(copyData));
+    m_redoStack.push_back(GraphicsFactory::copyMindMapData(*mindMapData));
 
     if (static_cast<int>(m_redoStack.size()) > m_maxHistorySize && m_maxHistorySize != -1)
     {
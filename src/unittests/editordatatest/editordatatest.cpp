@@ -15,15 +15,318 @@
 
 #include "editordatatest.hpp"
 
+#include "changejournal.hpp"
 #include "editordata.hpp"
+#include "graphobserver.hpp"
+#include "mapcache.hpp"
 #include "serializer.hpp"
 #include "mindmapdata.hpp"
+#include "node.hpp"
 #include "nodebase.hpp"
+#include "reader.hpp"
+#include "textedit.hpp"
 
 #include "mediator_mock.hpp"
 
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+namespace {
+
+class ObserverMock : public GraphObserver
+{
+public:
+
+    void nodeChanged(NodeBase &) override
+    {
+        m_nodesChanged++;
+    }
+
+    int m_nodesChanged = 0;
+};
+
+} // namespace
+
 EditorDataTest::EditorDataTest()
 {
+    // Keep the autosaves and the map cache out of the user's directories
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void EditorDataTest::testAutosave()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.path() + "/test.alz";
+
+    Mediator mediator;
+    EditorData editorData(mediator);
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    editorData.addNodeAt(QPointF(1, 2));
+    QVERIFY(editorData.saveMindMapAs(fileName));
+    QCOMPARE(editorData.autosaveFileName(), dir.path() + "/test.autosave.alb");
+
+    // Nothing to do for an unmodified mind map
+    QVERIFY(!editorData.autosave());
+
+    editorData.saveUndoPoint();
+    const auto node = editorData.addNodeAt(QPointF(3, 4));
+    QSignalSpy autosaveSpy(&editorData, &EditorData::autosaveFinished);
+    QTest::qSleep(10);
+    QVERIFY(editorData.autosave());
+
+    // Changes after taking the snapshot don't end up in the autosave
+    node->setLocation(QPointF(5, 6));
+    QVERIFY(autosaveSpy.wait());
+    QCOMPARE(autosaveSpy.at(0).at(0).toBool(), true);
+
+    const auto autosaved = Reader::readFromFile(editorData.autosaveFileName());
+    QCOMPARE(autosaved->graph().numNodes(), 2);
+    QCOMPARE(autosaved->graph().getNode(1)->location(), QPointF(3, 4));
+
+    // The original file is untouched
+    QCOMPARE(Reader::readFromFile(fileName)->graph().numNodes(), 1);
+
+    // The autosave can be recovered when the file is opened again, e.g. after a crash
+    QVERIFY(EditorData::hasNewerAutosave(fileName));
+    EditorData recoveringEditorData(mediator);
+    QSignalSpy loadedSpy(&recoveringEditorData, &EditorData::mindMapLoaded);
+    recoveringEditorData.recoverMindMapDataInBackground(fileName);
+    QVERIFY(loadedSpy.wait());
+    QCOMPARE(recoveringEditorData.fileName(), fileName);
+    QCOMPARE(recoveringEditorData.mindMapData()->graph().numNodes(), 2);
+    QCOMPARE(recoveringEditorData.isModified(), true);
+
+    // Saving makes the autosave obsolete
+    QVERIFY(recoveringEditorData.saveMindMap());
+    QCOMPARE(Reader::readFromFile(fileName)->graph().numNodes(), 2);
+    QVERIFY(!QFile::exists(editorData.autosaveFileName()));
+    QVERIFY(!EditorData::hasNewerAutosave(fileName));
+
+    // ...and so does discarding the changes by replacing the mind map
+    editorData.saveUndoPoint();
+    editorData.addNodeAt(QPointF(7, 8));
+    QVERIFY(editorData.autosave());
+    QVERIFY(autosaveSpy.wait());
+    QVERIFY(QFile::exists(editorData.autosaveFileName()));
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    QVERIFY(!QFile::exists(dir.path() + "/test.autosave.alb"));
+}
+
+void EditorDataTest::testAutosave_Untitled()
+{
+    Mediator mediator;
+    EditorData editorData(mediator);
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    editorData.addNodeAt(QPointF(1, 2));
+    editorData.saveUndoPoint();
+    editorData.addNodeAt(QPointF(3, 4));
+    QSignalSpy autosaveSpy(&editorData, &EditorData::autosaveFinished);
+    QVERIFY(editorData.autosave());
+    QVERIFY(autosaveSpy.wait());
+    QCOMPARE(autosaveSpy.at(0).at(0).toBool(), true);
+
+    // Each editor has its own autosave and the ones in use are not orphaned
+    const auto autosaveFileName = editorData.autosaveFileName();
+    QVERIFY(QFile::exists(autosaveFileName));
+    EditorData recoveringEditorData(mediator);
+    QVERIFY(recoveringEditorData.autosaveFileName() != autosaveFileName);
+    QVERIFY(!EditorData::orphanedAutosaveFileNames().contains(autosaveFileName));
+
+    // An autosave without a running editor is left after a crash
+    const auto crashedFileName = QFileInfo(autosaveFileName).path() + "/untitled-crashed.autosave.alb";
+    QFile::remove(crashedFileName);
+    QVERIFY(QFile::copy(autosaveFileName, crashedFileName));
+    QVERIFY(EditorData::orphanedAutosaveFileNames().contains(crashedFileName));
+
+    QSignalSpy loadedSpy(&recoveringEditorData, &EditorData::mindMapLoaded);
+    recoveringEditorData.recoverUntitledMindMapDataInBackground(crashedFileName);
+    QVERIFY(loadedSpy.wait());
+    QVERIFY(recoveringEditorData.fileName().isEmpty());
+    QCOMPARE(recoveringEditorData.mindMapData()->graph().numNodes(), 2);
+    QCOMPARE(recoveringEditorData.isModified(), true);
+
+    // The recovering editor takes the autosave over until the changes are discarded
+    QCOMPARE(recoveringEditorData.autosaveFileName(), crashedFileName);
+    QVERIFY(!EditorData::orphanedAutosaveFileNames().contains(crashedFileName));
+    recoveringEditorData.setMindMapData(std::make_shared<MindMapData>());
+    QVERIFY(!QFile::exists(crashedFileName));
+
+    // Unwanted orphans can be discarded
+    QVERIFY(QFile::copy(autosaveFileName, crashedFileName));
+    EditorData::discardOrphanedAutosave(crashedFileName);
+    QVERIFY(!QFile::exists(crashedFileName));
+
+    // Closing the mind map discards its autosave
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    QVERIFY(!QFile::exists(autosaveFileName));
+}
+
+void EditorDataTest::testJournal()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.path() + "/test.alz";
+    const auto journalFileName = ChangeJournal::journalFileName(fileName);
+
+    Mediator mediator;
+    EditorData editorData(mediator);
+    editorData.setJournalingEnabled(true);
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    const auto node0 = editorData.addNodeAt(QPointF(1, 2));
+    QVERIFY(editorData.saveMindMapAs(fileName));
+    QVERIFY(QFile::exists(journalFileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const auto fullSave = file.readAll();
+    file.close();
+
+    editorData.saveUndoPoint();
+    node0->setLocation(QPointF(3, 4));
+    node0->setLocation(QPointF(5, 6));
+    node0->setText("foo");
+    const auto node1 = editorData.addNodeAt(QPointF(7, 8));
+    editorData.addEdge(std::make_shared<Edge>(*node0, *node1))->setText("bar");
+    editorData.mindMapData()->setBackgroundColor(Qt::red);
+    QVERIFY(editorData.saveMindMap());
+    QCOMPARE(editorData.isModified(), false);
+
+    // The mind map file is untouched and the changes are applied from the journal
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), fullSave);
+    file.close();
+
+    auto data = Reader::readFromFile(fileName);
+    QCOMPARE(data->graph().numNodes(), 2);
+    QCOMPARE(data->graph().getNode(0)->location(), QPointF(5, 6));
+    QCOMPARE(data->graph().getNode(0)->text(), QString("foo"));
+    QCOMPARE(data->graph().getNode(1)->location(), QPointF(7, 8));
+    QCOMPARE(data->graph().getEdges().size(), size_t(1));
+    QCOMPARE(data->graph().getEdges().at(0)->text(), QString("bar"));
+    QCOMPARE(data->backgroundColor(), QColor(Qt::red));
+
+    // Undo replaces the graph so the whole file is written and the journal starts over
+    editorData.undo();
+    QVERIFY(editorData.saveMindMap());
+    data = Reader::readFromFile(fileName);
+    QCOMPARE(data->graph().numNodes(), 1);
+    QCOMPARE(data->graph().getNode(0)->location(), QPointF(1, 2));
+    QCOMPARE(QFileInfo(journalFileName).size(), qint64(24));
+}
+
+void EditorDataTest::testLoadInBackground()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.path() + "/test.alz";
+
+    Mediator mediator;
+    EditorData editorData(mediator);
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    editorData.addNodeAt(QPointF(1, 2));
+    editorData.addNodeAt(QPointF(3, 4));
+    QVERIFY(editorData.saveMindMapAs(fileName));
+
+    EditorData loadingEditorData(mediator);
+    QSignalSpy loadedSpy(&loadingEditorData, &EditorData::mindMapLoaded);
+    loadingEditorData.loadMindMapDataInBackground(fileName);
+    QVERIFY(loadingEditorData.isLoading());
+    QVERIFY(loadedSpy.wait());
+    QVERIFY(!loadingEditorData.isLoading());
+
+    // The loaded plain nodes are turned into graphics nodes
+    QCOMPARE(loadingEditorData.fileName(), fileName);
+    QCOMPARE(loadingEditorData.mindMapData()->graph().numNodes(), 2);
+    QVERIFY(std::dynamic_pointer_cast<Node>(loadingEditorData.getNodeByIndex(1)) != nullptr);
+    QCOMPARE(loadingEditorData.getNodeByIndex(1)->location(), QPointF(3, 4));
+}
+
+void EditorDataTest::testLoadInBackground_Failed()
+{
+    Mediator mediator;
+    EditorData editorData(mediator);
+    QSignalSpy failedSpy(&editorData, &EditorData::mindMapLoadFailed);
+    editorData.loadMindMapDataInBackground("/this/file/does/not/exist.alz");
+    QVERIFY(failedSpy.wait());
+    QVERIFY(!failedSpy.at(0).at(0).toString().isEmpty());
+    QVERIFY(editorData.mindMapData() == nullptr);
+}
+
+void EditorDataTest::testMapCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.path() + "/test.alz";
+    const MapCache cache(dir.path() + "/cache");
+
+    Mediator mediator;
+    EditorData editorData(mediator);
+    editorData.setMapCache(cache);
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    editorData.addNodeAt(QPointF(1, 2))->setText("Lorem");
+    QVERIFY(editorData.saveMindMapAs(fileName));
+
+    auto key = MapCache::key(fileName);
+    QVERIFY(!key.hash.isEmpty());
+    QVERIFY(cache.read(key) == nullptr);
+
+    // Loading parses the XML and caches the result
+    QSignalSpy loadedSpy(&editorData, &EditorData::mindMapLoaded);
+    editorData.loadMindMapDataInBackground(fileName);
+    QVERIFY(loadedSpy.wait());
+    auto cached = cache.read(key);
+    QVERIFY(cached != nullptr);
+    QCOMPARE(cached->graph().numNodes(), 1);
+    QCOMPARE(cached->graph().getNode(0)->text(), QString("Lorem"));
+    QCOMPARE(cached->graph().getNode(0)->location(), QPointF(1, 2));
+
+    // A different content doesn't match the entry anymore
+    editorData.getNodeByIndex(0)->setText("Ipsum");
+    QVERIFY(editorData.saveMindMapAs(fileName));
+    const auto oldKey = key;
+    key = MapCache::key(fileName);
+    QVERIFY(key.hash != oldKey.hash);
+    QVERIFY(cache.read(key) == nullptr);
+
+    editorData.loadMindMapDataInBackground(fileName);
+    QVERIFY(loadedSpy.wait());
+    QCOMPARE(editorData.getNodeByIndex(0)->text(), QString("Ipsum"));
+    QCOMPARE(cache.read(key)->graph().getNode(0)->text(), QString("Ipsum"));
+}
+
+void EditorDataTest::testNodeTextEdit()
+{
+    Mediator mediator;
+    EditorData editorData(mediator);
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    const auto node = editorData.addNodeAt(QPointF(1, 2));
+
+    TextEdit * textEdit = nullptr;
+    for (auto && item : node->childItems())
+    {
+        textEdit = textEdit ? textEdit : dynamic_cast<TextEdit *>(item);
+    }
+    QVERIFY(textEdit);
+
+    ObserverMock observer;
+    auto & graph = editorData.mindMapData()->graph();
+    graph.addObserver(observer);
+    const auto generation = graph.generation();
+
+    // Typing updates the text edit before it emits textChanged
+    textEdit->setPlainText("typed");
+    emit textEdit->textChanged("typed");
+
+    QCOMPARE(node->text(), QString("typed"));
+    QCOMPARE(node->NodeBase::text(), QString("typed"));
+    QVERIFY(graph.generation() > generation);
+    QCOMPARE(observer.m_nodesChanged, 1);
+
+    graph.removeObserver(observer);
 }
 
 void EditorDataTest::testUndoSimple()
@@ -72,6 +375,111 @@ void EditorDataTest::testRedoSimple()
     QCOMPARE(editorData.mindMapData()->graph().numNodes(), 2);
 }
 
+void EditorDataTest::testSaveCompact()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.path() + "/test.alz";
+
+    Mediator mediator;
+    EditorData editorData(mediator);
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    editorData.addNodeAt(QPointF(1, 2));
+    editorData.addNodeAt(QPointF(3, 4));
+    const auto node = editorData.addNodeAt(QPointF(5, 6));
+    editorData.mindMapData()->graph().deleteNode(1);
+
+    // A failed save leaves the indices alone
+    QVERIFY(!editorData.saveMindMapAs(dir.path() + "/missing/test.alz"));
+    QCOMPARE(node->index(), 2);
+
+    QVERIFY(editorData.saveMindMapAs(fileName));
+    QCOMPARE(node->index(), 1);
+    const auto data = Reader::readFromFile(fileName);
+    QCOMPARE(data->graph().numNodes(), 2);
+    QCOMPARE(data->graph().getNode(1)->location(), QPointF(5, 6));
+}
+
+void EditorDataTest::testSaveCompactFileFormat()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.path() + "/test.alz";
+
+    Mediator mediator;
+    EditorData editorData(mediator);
+    editorData.setCompactFileFormatEnabled(true);
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    editorData.addNodeAt(QPointF(1, 2))->setText("Lorem");
+    editorData.addNodeAt(QPointF(3, 4))->setText("Lorem");
+    QVERIFY(editorData.saveMindMapAs(fileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const auto content = file.readAll();
+    QVERIFY(content.contains("<strings>"));
+    QCOMPARE(content.count("Lorem"), 1);
+    file.close();
+
+    const auto data = Reader::readFromFile(fileName);
+    QCOMPARE(data->graph().numNodes(), 2);
+    QCOMPARE(data->graph().getNode(1)->text(), QString("Lorem"));
+}
+
+void EditorDataTest::testSaveUnchanged()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fileName = dir.path() + "/test.alz";
+
+    Mediator mediator;
+    EditorData editorData(mediator);
+    editorData.setMindMapData(std::make_shared<MindMapData>());
+    editorData.addNodeAt(QPointF(1, 2));
+    QVERIFY(editorData.saveMindMapAs(fileName));
+
+    // Journaling is opt-in
+    QVERIFY(!QFile::exists(ChangeJournal::journalFileName(fileName)));
+
+    // Undoing back to the saved state is not a modification
+    editorData.saveUndoPoint();
+    editorData.getNodeByIndex(0)->setLocation(QPointF(3, 4));
+    QCOMPARE(editorData.isModified(), true);
+    editorData.undo();
+    QCOMPARE(editorData.isModified(), false);
+
+    // ...but redoing is
+    editorData.redo();
+    QCOMPARE(editorData.isModified(), true);
+    editorData.undo();
+    QCOMPARE(editorData.isModified(), false);
+
+    // The file is not written if the content hasn't changed, e.g. after moving a node back
+    const auto modified = QFileInfo(fileName).lastModified();
+    QTest::qSleep(10);
+    editorData.saveUndoPoint();
+    editorData.getNodeByIndex(0)->setLocation(QPointF(5, 6));
+    editorData.getNodeByIndex(0)->setLocation(QPointF(1, 2));
+    QVERIFY(editorData.saveMindMap());
+    QCOMPARE(editorData.isModified(), false);
+    QCOMPARE(QFileInfo(fileName).lastModified(), modified);
+
+    // ...unless the file has been changed by someone else since
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("foo");
+    file.close();
+
+    QVERIFY(editorData.saveMindMap());
+    QCOMPARE(Reader::readFromFile(fileName)->graph().getNode(0)->location(), QPointF(1, 2));
+
+    // A real change is written
+    editorData.saveUndoPoint();
+    editorData.mindMapData()->setBackgroundColor(Qt::red);
+    QVERIFY(editorData.saveMindMap());
+    QCOMPARE(Reader::readFromFile(fileName)->backgroundColor(), QColor(Qt::red));
+}
+
 void EditorDataTest::testUndoBackgroundColor()
 {
     Mediator mediator;
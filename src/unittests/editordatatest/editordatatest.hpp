@@ -25,9 +25,29 @@ public:
 
 private slots:
 
+    void testAutosave();
+
+    void testAutosave_Untitled();
+
+    void testJournal();
+
+    void testLoadInBackground();
+
+    void testLoadInBackground_Failed();
+
+    void testMapCache();
+
+    void testNodeTextEdit();
+
     void testUndoSimple();
 
     void testRedoSimple();
 
+    void testSaveCompact();
+
+    void testSaveCompactFileFormat();
+
+    void testSaveUnchanged();
+
     void testUndoBackgroundColor();
 };
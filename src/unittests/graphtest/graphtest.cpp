@@ -16,10 +16,60 @@
 #include "graphtest.hpp"
 
 #include "graph.hpp"
+#include "graphobserver.hpp"
 #include "nodebase.hpp"
 
+#include <string>
+
 using std::make_shared;
 
+namespace {
+
+class ObserverMock : public GraphObserver
+{
+public:
+
+    void nodeAdded(NodeBase & node) override
+    {
+        log.push_back("nodeAdded " + std::to_string(node.index()));
+    }
+
+    void nodeRemoved(NodeBase & node) override
+    {
+        log.push_back("nodeRemoved " + std::to_string(node.index()));
+    }
+
+    void nodeChanged(NodeBase & node) override
+    {
+        log.push_back("nodeChanged " + std::to_string(node.index()));
+    }
+
+    void edgeAdded(EdgeBase & edge) override
+    {
+        log.push_back("edgeAdded " + std::to_string(edge.sourceNodeBase().index()) + " " + std::to_string(edge.targetNodeBase().index()));
+    }
+
+    void edgeRemoved(EdgeBase & edge) override
+    {
+        log.push_back("edgeRemoved " + std::to_string(edge.sourceNodeBase().index()) + " " + std::to_string(edge.targetNodeBase().index()));
+    }
+
+    void edgeChanged(EdgeBase & edge) override
+    {
+        log.push_back("edgeChanged " + std::to_string(edge.sourceNodeBase().index()) + " " + std::to_string(edge.targetNodeBase().index()));
+    }
+
+    std::vector<std::string> log;
+};
+
+//! Connects the nodes of given indices with a plain EdgeBase.
+void addEdge(Graph & graph, int node0, int node1)
+{
+    graph.addEdge(make_shared<EdgeBase>(*graph.getNode(node0), *graph.getNode(node1)));
+}
+
+} // namespace
+
 GraphTest::GraphTest()
 {
 }
@@ -61,8 +111,8 @@ void GraphTest::testAddEdgeByIndices()
     auto node1 = make_shared<NodeBase>();
     dut.addNode(node1);
 
-    dut.addEdge(node0->index(), node1->index());
-    dut.addEdge(node0->index(), node1->index()); // Check that doubles are ignored
+    addEdge(dut, node0->index(), node1->index());
+    addEdge(dut, node0->index(), node1->index()); // Check that doubles are ignored
 
     auto edgesFrom0 = dut.getEdgesFromNode(node0);
     QCOMPARE(edgesFrom0.size(), static_cast<size_t>(1));
@@ -77,6 +127,37 @@ void GraphTest::testAddEdgeByIndices()
     QCOMPARE(dut.getEdgesToNode(node0).size(), static_cast<size_t>(0));
 }
 
+void GraphTest::testAddEdge_AfterDeletion()
+{
+    Graph dut;
+
+    auto node0 = make_shared<NodeBase>();
+    dut.addNode(node0);
+
+    auto node1 = make_shared<NodeBase>();
+    dut.addNode(node1);
+
+    dut.addEdge(make_shared<EdgeBase>(*node0, *node1));
+    dut.addEdge(make_shared<EdgeBase>(*node1, *node0));
+
+    QCOMPARE(dut.getEdges().size(), static_cast<size_t>(2));
+    QCOMPARE(dut.getEdgesFromNode(node0).size(), static_cast<size_t>(1));
+    QCOMPARE(dut.getEdgesToNode(node0).size(), static_cast<size_t>(1));
+
+    dut.addEdge(make_shared<EdgeBase>(*node0, *node1)); // Doubles must be ignored
+    QCOMPARE(dut.getEdges().size(), static_cast<size_t>(2));
+
+    dut.deleteNode(node1->index());
+    QCOMPARE(dut.getEdges().size(), static_cast<size_t>(0));
+
+    auto node2 = make_shared<NodeBase>();
+    node2->setIndex(node1->index());
+    dut.addNode(node2);
+
+    dut.addEdge(make_shared<EdgeBase>(*node0, *node2)); // Key of the deleted edge must not block this
+    QCOMPARE(dut.getEdges().size(), static_cast<size_t>(1));
+}
+
 void GraphTest::testAddNode()
 {
     Graph dut;
@@ -105,6 +186,31 @@ void GraphTest::testAddNode()
     QCOMPARE(node->index(), 667); // Node index should be automatically 667
 }
 
+void GraphTest::testAddNode_ReusesDeletedIndex()
+{
+    Graph dut;
+
+    for (int i = 0; i < 4; i++)
+    {
+        dut.addNode(make_shared<NodeBase>());
+    }
+
+    dut.deleteNode(2);
+    dut.deleteNode(1);
+
+    auto node = make_shared<NodeBase>();
+    dut.addNode(node);
+    QCOMPARE(node->index(), 1); // The lowest free index should be used
+
+    node = make_shared<NodeBase>();
+    node->setIndex(2);
+    dut.addNode(node); // Forced index takes the slot out of the free list
+
+    node = make_shared<NodeBase>();
+    dut.addNode(node);
+    QCOMPARE(node->index(), 4);
+}
+
 void GraphTest::testAddTwoNodes()
 {
     Graph dut;
@@ -143,6 +249,97 @@ void GraphTest::testAreNodesDirectlyConnected()
     QVERIFY(!dut.areDirectlyConnected(node0, node2));
 }
 
+void GraphTest::testBuild()
+{
+    Graph dut;
+
+    auto node0 = make_shared<NodeBase>();
+    auto node1 = make_shared<NodeBase>();
+    node1->setIndex(5);
+    auto node2 = make_shared<NodeBase>();
+    auto orphan = make_shared<NodeBase>();
+    orphan->setIndex(7);
+
+    ObserverMock observer;
+    dut.addObserver(observer);
+    const auto generation = dut.generation();
+
+    dut.build({node0, node1, node2}, {
+        make_shared<EdgeBase>(*node0, *node1),
+        make_shared<EdgeBase>(*node0, *node1), // Double
+        make_shared<EdgeBase>(*node1, *node2),
+        make_shared<EdgeBase>(*node1, *orphan) // Node not in the graph
+    });
+
+    dut.removeObserver(observer);
+
+    QCOMPARE(dut.generation(), generation + 1);
+    QCOMPARE(observer.log, std::vector<std::string>({
+        "nodeAdded 0",
+        "nodeAdded 5",
+        "nodeAdded 6",
+        "edgeAdded 0 5",
+        "edgeAdded 5 6"}));
+
+    QCOMPARE(dut.numNodes(), 3);
+    QCOMPARE(node0->index(), 0);
+    QCOMPARE(node1->index(), 5);
+    QCOMPARE(node2->index(), 6);
+    QCOMPARE(dut.getEdges().size(), static_cast<size_t>(2));
+    QCOMPARE(dut.numEdgesFromNode(node1->index()), 1);
+    QCOMPARE(dut.numEdgesToNode(node1->index()), 1);
+    QCOMPARE(dut.numEdgesToNode(orphan->index()), 0);
+    QVERIFY(dut.areDirectlyConnected(node0, node1));
+}
+
+void GraphTest::testCompact()
+{
+    Graph dut;
+
+    std::vector<NodeBasePtr> nodes;
+    for (int i = 0; i < 4; i++)
+    {
+        nodes.push_back(make_shared<NodeBase>());
+    }
+
+    nodes.at(3)->setIndex(666);
+
+    for (auto && node : nodes)
+    {
+        dut.addNode(node);
+    }
+
+    addEdge(dut, nodes.at(0)->index(), nodes.at(2)->index());
+    addEdge(dut, nodes.at(2)->index(), nodes.at(3)->index());
+
+    dut.deleteNode(nodes.at(1)->index());
+
+    ObserverMock observer;
+    dut.addObserver(observer);
+    dut.compact();
+    dut.removeObserver(observer);
+    QVERIFY(observer.log.empty());
+
+    QCOMPARE(dut.numNodes(), 3);
+    QCOMPARE(nodes.at(0)->index(), 0);
+    QCOMPARE(nodes.at(2)->index(), 1);
+    QCOMPARE(nodes.at(3)->index(), 2);
+    QCOMPARE(dut.getNode(2), nodes.at(3));
+    QVERIFY(dut.getNode(666) == nullptr);
+
+    QVERIFY(dut.areDirectlyConnected(nodes.at(0), nodes.at(2)));
+    QVERIFY(dut.areDirectlyConnected(nodes.at(2), nodes.at(3)));
+    QCOMPARE(dut.getEdgesFromNode(nodes.at(2)).size(), static_cast<size_t>(1));
+    QCOMPARE(dut.getEdgesToNode(nodes.at(2)).size(), static_cast<size_t>(1));
+
+    addEdge(dut, nodes.at(0)->index(), nodes.at(2)->index()); // Doubles must be ignored
+    QCOMPARE(dut.getEdges().size(), static_cast<size_t>(2));
+
+    auto node = make_shared<NodeBase>();
+    dut.addNode(node);
+    QCOMPARE(node->index(), 3);
+}
+
 void GraphTest::testDeleteNode()
 {
     Graph dut;
@@ -182,6 +379,112 @@ void GraphTest::testDeleteNodeInvolvingEdge()
     QCOMPARE(dut.getEdgesToNode(node1).size(), static_cast<size_t>(0));
 }
 
+void GraphTest::testDeleteNodeInBetween()
+{
+    Graph dut;
+
+    auto node0 = make_shared<NodeBase>();
+    dut.addNode(node0);
+
+    auto node1 = make_shared<NodeBase>();
+    dut.addNode(node1);
+
+    auto node2 = make_shared<NodeBase>();
+    dut.addNode(node2);
+
+    dut.addEdge(make_shared<EdgeBase>(*node0, *node1));
+    dut.addEdge(make_shared<EdgeBase>(*node1, *node2));
+    dut.addEdge(make_shared<EdgeBase>(*node0, *node2));
+
+    dut.deleteNode(node1->index());
+
+    QCOMPARE(dut.getEdges().size(), static_cast<size_t>(1));
+
+    auto edgesFrom0 = dut.getEdgesFromNode(node0);
+    QCOMPARE(edgesFrom0.size(), static_cast<size_t>(1));
+    QCOMPARE(edgesFrom0.at(0)->targetNodeBase().index(), node2->index());
+
+    auto edgesTo2 = dut.getEdgesToNode(node2);
+    QCOMPARE(edgesTo2.size(), static_cast<size_t>(1));
+    QCOMPARE(edgesTo2.at(0)->sourceNodeBase().index(), node0->index());
+}
+
+void GraphTest::testDeleteNodes()
+{
+    Graph dut;
+
+    std::vector<NodeBasePtr> nodes;
+    for (int i = 0; i < 5; i++)
+    {
+        nodes.push_back(make_shared<NodeBase>());
+        dut.addNode(nodes.back());
+    }
+
+    // Star around node 0 plus a chain 1 -> 2 -> 3 -> 4
+    for (int i = 1; i < 5; i++)
+    {
+        addEdge(dut, 0, i);
+    }
+
+    for (int i = 1; i < 4; i++)
+    {
+        addEdge(dut, i, i + 1);
+    }
+
+    dut.deleteNodes({0, 2, 666});
+
+    QCOMPARE(dut.numNodes(), 3);
+    QVERIFY(dut.getNode(0) == nullptr);
+    QVERIFY(dut.getNode(2) == nullptr);
+
+    // Only 3 -> 4 should survive
+    QCOMPARE(dut.getEdges().size(), static_cast<size_t>(1));
+    QCOMPARE(dut.getEdgesFromNode(nodes.at(1)).size(), static_cast<size_t>(0));
+    QCOMPARE(dut.getEdgesToNode(nodes.at(3)).size(), static_cast<size_t>(0));
+    QCOMPARE(dut.getEdgesFromNode(nodes.at(3)).size(), static_cast<size_t>(1));
+    QCOMPARE(dut.getEdgesToNode(nodes.at(4)).size(), static_cast<size_t>(1));
+}
+
+void GraphTest::testForEachEdge()
+{
+    Graph dut;
+
+    auto node0 = make_shared<NodeBase>();
+    dut.addNode(node0);
+
+    auto node1 = make_shared<NodeBase>();
+    dut.addNode(node1);
+
+    auto node2 = make_shared<NodeBase>();
+    dut.addNode(node2);
+
+    dut.addEdge(make_shared<EdgeBase>(*node0, *node1));
+    dut.addEdge(make_shared<EdgeBase>(*node0, *node2));
+    dut.addEdge(make_shared<EdgeBase>(*node2, *node1));
+
+    std::vector<int> targets;
+    dut.forEachEdgeFromNode(node0->index(), [&] (EdgeBase & edge) {
+        targets.push_back(edge.targetNodeBase().index());
+    });
+    QCOMPARE(targets, std::vector<int>({node1->index(), node2->index()}));
+
+    std::vector<int> sources;
+    dut.forEachEdgeToNode(node1->index(), [&] (EdgeBase & edge) {
+        sources.push_back(edge.sourceNodeBase().index());
+    });
+    QCOMPARE(sources, std::vector<int>({node0->index(), node2->index()}));
+
+    std::vector<int> connected;
+    dut.forEachNodeConnectedToNode(node2->index(), [&] (NodeBase & node) {
+        connected.push_back(node.index());
+    });
+    QCOMPARE(connected, std::vector<int>({node0->index(), node1->index()}));
+
+    QCOMPARE(dut.numEdgesFromNode(node0->index()), 2);
+    QCOMPARE(dut.numEdgesToNode(node0->index()), 0);
+    QCOMPARE(dut.numEdgesToNode(666), 0);
+}
+
 void GraphTest::testGetEdges()
 {
     Graph dut;
@@ -275,4 +578,179 @@ void GraphTest::testGetNodeByIndex_NotFound()
     QVERIFY(dut.getNode(1) == nullptr);
 }
 
+void GraphTest::testGetNodeByIndex_Deleted()
+{
+    Graph dut;
+
+    auto node0 = make_shared<NodeBase>();
+    dut.addNode(node0);
+
+    auto node1 = make_shared<NodeBase>();
+    node1->setIndex(666);
+    dut.addNode(node1);
+
+    dut.deleteNode(node0->index());
+
+    QVERIFY(dut.getNode(0) == nullptr);
+    QCOMPARE(node1, dut.getNode(666));
+
+    dut.clear();
+
+    QVERIFY(dut.getNode(666) == nullptr);
+}
+
+void GraphTest::testNodeStore()
+{
+    auto node0 = make_shared<NodeBase>();
+    node0->setLocation(QPointF(-10, 0));
+    node0->setSize(QSizeF(4, 2));
+
+    auto node1 = make_shared<NodeBase>();
+    node1->setLocation(QPointF(0, 10));
+    node1->setSize(QSizeF(2, 4));
+
+    auto node2 = make_shared<NodeBase>();
+    node2->setLocation(QPointF(10, 0));
+    node2->setSize(QSizeF(2, 2));
+    node2->setColor(QColor(1, 2, 3));
+
+    {
+        Graph dut;
+        dut.addNode(node0);
+        dut.addNode(node1);
+        dut.addNode(node2);
+
+        QCOMPARE(dut.nodeStore().size(), 3);
+        QCOMPARE(dut.nodeStore().boundingRect(), QRectF(-12, -1, 23, 13));
+
+        // Setters must write through to the store
+        node1->setLocation(QPointF(0, 20));
+        QCOMPARE(dut.nodeStore().locations().at(1), QPointF(0, 20));
+
+        dut.deleteNode(node1->index());
+
+        // The store must stay in the order of getNodes()
+        QCOMPARE(dut.nodeStore().indices(), std::vector<int>({node0->index(), node2->index()}));
+        QCOMPARE(dut.nodeStore().locations().at(1), node2->location());
+        QCOMPARE(dut.nodeStore().colors().at(1), QColor(1, 2, 3));
+
+        // Deleted node must keep its attributes
+        QCOMPARE(node1->location(), QPointF(0, 20));
+        QCOMPARE(node1->size(), QSizeF(2, 4));
+
+        node2->setLocation(QPointF(20, 0));
+    }
+
+    // Nodes must keep their attributes when the graph is gone
+    QCOMPARE(node2->location(), QPointF(20, 0));
+    QCOMPARE(node2->color(), QColor(1, 2, 3));
+    QCOMPARE(node2->index(), 2);
+}
+
+void GraphTest::testObserver()
+{
+    Graph dut;
+    ObserverMock observer;
+    dut.addObserver(observer);
+
+    auto node0 = make_shared<NodeBase>();
+    dut.addNode(node0);
+
+    auto node1 = make_shared<NodeBase>();
+    dut.addNode(node1);
+
+    auto edge = make_shared<EdgeBase>(*node0, *node1);
+    dut.addEdge(edge);
+    dut.addEdge(make_shared<EdgeBase>(*node0, *node1)); // Ignored doubles must not be notified
+
+    node1->setLocation(QPointF(1, 1));
+    edge->setText("Lorem");
+
+    dut.deleteNode(node0->index());
+
+    node0->setText("Not in the graph anymore");
+    edge->setText("Not in the graph anymore");
+
+    dut.removeObserver(observer);
+    dut.addNode(make_shared<NodeBase>());
+
+    QCOMPARE(observer.log, std::vector<std::string>({
+        "nodeAdded 0",
+        "nodeAdded 1",
+        "edgeAdded 0 1",
+        "nodeChanged 1",
+        "edgeChanged 0 1",
+        "edgeRemoved 0 1",
+        "nodeRemoved 0"}));
+}
+
+void GraphTest::testGeneration()
+{
+    Graph dut;
+
+    auto generation = dut.generation();
+
+    auto node0 = make_shared<NodeBase>();
+    dut.addNode(node0);
+    QVERIFY(dut.generation() > generation);
+    generation = dut.generation();
+
+    const auto snapshot = dut.snapshot();
+    QCOMPARE(dut.snapshot(), snapshot); // Unchanged graph should give the cached snapshot
+    QCOMPARE(dut.generation(), generation);
+
+    node0->setColor(QColor(1, 2, 3));
+    QVERIFY(dut.generation() > generation);
+    generation = dut.generation();
+
+    QVERIFY(dut.snapshot() != snapshot);
+    QCOMPARE(dut.snapshot()->colors().at(0), QColor(1, 2, 3));
+
+    dut.deleteNode(node0->index());
+    QVERIFY(dut.generation() > generation);
+}
+
+void GraphTest::testSnapshot()
+{
+    Graph dut;
+
+    auto node0 = make_shared<NodeBase>();
+    node0->setLocation(QPointF(1, 2));
+    node0->setText("Lorem");
+    dut.addNode(node0);
+
+    auto node1 = make_shared<NodeBase>();
+    node1->setIndex(666);
+    node1->setColor(QColor(1, 2, 3));
+    dut.addNode(node1);
+
+    auto node2 = make_shared<NodeBase>();
+    dut.addNode(node2);
+
+    auto edge = make_shared<EdgeBase>(*node1, *node0);
+    edge->setText("ipsum");
+    dut.addEdge(edge);
+    dut.addEdge(make_shared<EdgeBase>(*node1, *node2));
+    dut.addEdge(make_shared<EdgeBase>(*node2, *node0));
+
+    const auto snapshot = dut.snapshot();
+
+    // The snapshot must not change when the graph changes
+    node0->setText("dolor");
+    dut.deleteNode(node2->index());
+
+    QCOMPARE(snapshot->numNodes(), 3);
+    QCOMPARE(snapshot->numEdges(), 3);
+    QCOMPARE(snapshot->indices(), std::vector<int>({0, 666, 667}));
+    QCOMPARE(snapshot->position(666), 1);
+    QCOMPARE(snapshot->position(1), -1);
+    QCOMPARE(snapshot->locations().at(0), QPointF(1, 2));
+    QCOMPARE(snapshot->texts().at(0), QString("Lorem"));
+    QCOMPARE(snapshot->colors().at(1), QColor(1, 2, 3));
+
+    QCOMPARE(snapshot->edgeOffsets(), std::vector<int>({0, 0, 2, 3}));
+    QCOMPARE(snapshot->edgeTargets(), std::vector<int>({0, 2, 0}));
+    QCOMPARE(snapshot->edgeTexts().at(0), QString("ipsum"));
+}
+
 QTEST_GUILESS_MAIN(GraphTest)
@@ -29,16 +29,30 @@ private slots:
 
     void testAddEdgeByIndices();
 
+    void testAddEdge_AfterDeletion();
+
     void testAddNode();
 
+    void testAddNode_ReusesDeletedIndex();
+
     void testAddTwoNodes();
 
     void testAreNodesDirectlyConnected();
 
+    void testBuild();
+
+    void testCompact();
+
     void testDeleteNode();
 
     void testDeleteNodeInvolvingEdge();
 
+    void testDeleteNodeInBetween();
+
+    void testDeleteNodes();
+
+    void testForEachEdge();
+
     void testGetEdges();
 
     void testGetNodes();
@@ -48,4 +62,14 @@ private slots:
     void testGetNodeByIndex();
 
     void testGetNodeByIndex_NotFound();
+
+    void testGetNodeByIndex_Deleted();
+
+    void testNodeStore();
+
+    void testObserver();
+
+    void testGeneration();
+
+    void testSnapshot();
 };
@@ -15,10 +15,17 @@
 
 #include "serializertest.hpp"
 
+#include "binarymapview.hpp"
+#include "binaryserializer.hpp"
+#include "compresseddevice.hpp"
 #include "serializer.hpp"
 #include "mindmapdata.hpp"
 #include "nodebase.hpp"
 
+#include <QBuffer>
+#include <QDomElement>
+#include <QStringList>
+
 SerializerTest::SerializerTest()
 {
 }
@@ -48,6 +55,261 @@ void SerializerTest::testBackgroundColor()
     QCOMPARE(inData->backgroundColor(), outData.backgroundColor());
 }
 
+void SerializerTest::testBinaryFormat()
+{
+    MindMapData outData;
+    outData.setBackgroundColor(QColor(1, 2, 3));
+
+    auto outNode0 = std::make_shared<NodeBase>();
+    outNode0->setColor(QColor(4, 5, 6));
+    outNode0->setLocation(QPointF(333.333, 666.666));
+    outNode0->setSize(QSize(123, 321));
+    outNode0->setText("Lorem ipsum");
+    outData.graph().addNode(outNode0);
+
+    auto outNode1 = std::make_shared<NodeBase>();
+    outNode1->setIndex(5);
+    outData.graph().addNode(outNode1);
+
+    auto edge = std::make_shared<EdgeBase>(*outNode1, *outNode0);
+    edge->setText("dolor");
+    outData.graph().addEdge(edge);
+
+    // Serialize
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(BinarySerializer::toBinary(outData, buffer));
+
+    const auto bytes = buffer.data();
+    const BinaryMapView view(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size());
+    QVERIFY(view.isValid());
+    QCOMPARE(view.version(), BinaryMapView::VERSION);
+    QCOMPARE(view.numNodes(), 2);
+    QCOMPARE(view.numEdges(), 1);
+    QCOMPARE(view.nodeText(0), QString("Lorem ipsum"));
+
+    // Deserialize
+    const auto inData = BinarySerializer::fromBinary(view);
+    QVERIFY(inData != nullptr);
+    QCOMPARE(inData->version(), QString(VERSION));
+    QCOMPARE(inData->backgroundColor(), outData.backgroundColor());
+    QCOMPARE(inData->graph().numNodes(), 2);
+
+    auto node = inData->graph().getNode(0);
+    QVERIFY(node != nullptr);
+    QCOMPARE(node->color(), outNode0->color());
+    QCOMPARE(node->location(), outNode0->location());
+    QCOMPARE(node->size(), outNode0->size());
+    QCOMPARE(node->text(), outNode0->text());
+
+    // Nodes are numbered densely in the file
+    auto edges = inData->graph().getEdgesFromNode(inData->graph().getNode(1));
+    QCOMPARE(edges.size(), static_cast<size_t>(1));
+    QCOMPARE((*edges.begin())->targetNodeBase().index(), 0);
+    QCOMPARE((*edges.begin())->text(), edge->text());
+}
+
+void SerializerTest::testBinaryFormat_Invalid()
+{
+    MindMapData outData;
+    outData.graph().addNode(std::make_shared<NodeBase>());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(BinarySerializer::toBinary(outData, buffer));
+
+    // Truncated
+    auto bytes = buffer.data();
+    bytes.chop(1);
+    QVERIFY(!BinaryMapView(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size()).isValid());
+
+    // Unknown version
+    bytes = buffer.data();
+    bytes[4] = 99;
+    QVERIFY(BinarySerializer::fromBinary(BinaryMapView(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size())) == nullptr);
+
+    // Text out of the string table
+    bytes = buffer.data();
+    bytes[BinaryMapView::HEADER_SIZE + 44] = 100;
+    QVERIFY(BinarySerializer::fromBinary(BinaryMapView(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size())) == nullptr);
+}
+
+void SerializerTest::testBinaryFormat_ManyNodes()
+{
+    // Enough nodes to be decoded in several chunks
+    MindMapData outData;
+    for (int i = 0; i < 10000; i++)
+    {
+        auto outNode = std::make_shared<NodeBase>();
+        outNode->setLocation(QPointF(i, -i));
+        outNode->setText(QString::number(i));
+        outData.graph().addNode(outNode);
+
+        if (i)
+        {
+            outData.graph().addEdge(std::make_shared<EdgeBase>(*outData.graph().getNode(i - 1), *outNode));
+        }
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(BinarySerializer::toBinary(outData, buffer));
+
+    const auto bytes = buffer.data();
+    const auto inData = BinarySerializer::fromBinary(BinaryMapView(reinterpret_cast<const uchar *>(bytes.constData()), bytes.size()));
+    QVERIFY(inData != nullptr);
+    QCOMPARE(inData->graph().numNodes(), 10000);
+    QCOMPARE(inData->graph().getEdges().size(), static_cast<size_t>(9999));
+
+    // Decoded nodes keep the record order
+    for (int i = 0; i < 10000; i++)
+    {
+        const auto & node = inData->graph().getNodes().at(i);
+        QCOMPARE(node->index(), i);
+        QCOMPARE(node->location(), QPointF(i, -i));
+        QCOMPARE(node->text(), QString::number(i));
+    }
+}
+
+void SerializerTest::testCompressedDesign()
+{
+    // Enough nodes to span several chunks
+    MindMapData outData;
+    for (int i = 0; i < 2000; i++)
+    {
+        auto outNode = std::make_shared<NodeBase>();
+        outNode->setLocation(QPointF(i, i));
+        outNode->setText(QString("Node %1").arg(i));
+        outData.graph().addNode(outNode);
+    }
+
+    // Serialize
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    CompressedDevice outDevice(buffer);
+    QVERIFY(outDevice.open(QIODevice::WriteOnly));
+    QVERIFY(Serializer::toXml(outData, outDevice));
+    outDevice.close();
+    buffer.close();
+
+    QVERIFY(CompressedDevice::hasMagic(buffer.data()));
+
+    // Deserialize
+    buffer.open(QIODevice::ReadOnly);
+    CompressedDevice inDevice(buffer);
+    QVERIFY(inDevice.open(QIODevice::ReadOnly));
+    const auto inData = Serializer::fromXml(inDevice);
+    QVERIFY(inData != nullptr);
+    QCOMPARE(inData->graph().numNodes(), 2000);
+    QCOMPARE(inData->graph().getNode(1999)->location(), QPointF(1999, 1999));
+    QCOMPARE(inData->graph().getNode(1999)->text(), QString("Node 1999"));
+    QVERIFY(inDevice.atEnd());
+}
+
+void SerializerTest::testCompressedDesign_Truncated()
+{
+    MindMapData outData;
+    outData.graph().addNode(std::make_shared<NodeBase>());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    CompressedDevice outDevice(buffer);
+    QVERIFY(outDevice.open(QIODevice::WriteOnly));
+    QVERIFY(Serializer::toXml(outData, outDevice));
+    outDevice.close();
+
+    auto bytes = buffer.data();
+    bytes.chop(10);
+    QBuffer truncated(&bytes);
+    truncated.open(QIODevice::ReadOnly);
+    CompressedDevice inDevice(truncated);
+    QVERIFY(inDevice.open(QIODevice::ReadOnly));
+    QVERIFY(Serializer::fromXml(inDevice) == nullptr);
+}
+
+void SerializerTest::testCompressedDesign_OversizedChunk()
+{
+    // Valid header followed by a chunk size far beyond anything the writer produces
+    QByteArray bytes("HMRZ\x01\x00\x00\x00\xff\xff\xff\x7f", 12);
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    CompressedDevice inDevice(buffer);
+    QVERIFY(inDevice.open(QIODevice::ReadOnly));
+    QVERIFY(Serializer::fromXml(inDevice) == nullptr);
+}
+
+void SerializerTest::testCopy()
+{
+    MindMapData outData;
+    outData.setBackgroundColor(QColor(1, 2, 3));
+
+    auto outNode0 = std::make_shared<NodeBase>();
+    outNode0->setLocation(QPointF(1, 2));
+    outNode0->setText("lorem");
+    outData.graph().addNode(outNode0);
+
+    auto outNode1 = std::make_shared<NodeBase>();
+    outData.graph().addNode(outNode1);
+
+    auto edge = std::make_shared<EdgeBase>(*outNode0, *outNode1);
+    edge->setText("ipsum");
+    outData.graph().addEdge(edge);
+
+    // The copy must not share nodes with the original
+    const MindMapData inData(outData);
+    QCOMPARE(inData.backgroundColor(), QColor(1, 2, 3));
+    QCOMPARE(inData.graph().numNodes(), 2);
+    QVERIFY(inData.graph().getNodes().at(0) != outNode0);
+    QCOMPARE(inData.graph().getNodes().at(0)->location(), QPointF(1, 2));
+    QCOMPARE(inData.graph().getNodes().at(0)->text(), QString("lorem"));
+    QCOMPARE(inData.graph().getEdges().size(), static_cast<size_t>(1));
+    QCOMPARE(&inData.graph().getEdges().at(0)->sourceNodeBase(), inData.graph().getNodes().at(0).get());
+    QCOMPARE(inData.graph().getEdges().at(0)->text(), QString("ipsum"));
+}
+
+void SerializerTest::testCorruptedDesign()
+{
+    QByteArray bytes("<?xml version='1.0' encoding='UTF-8'?><design version='1.0'><graph><node index='0'>");
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+
+    QVERIFY(Serializer::fromXml(buffer) == nullptr);
+}
+
+void SerializerTest::testEdgeOrder()
+{
+    MindMapData outData;
+
+    auto outNode0 = std::make_shared<NodeBase>();
+    outData.graph().addNode(outNode0);
+
+    auto outNode1 = std::make_shared<NodeBase>();
+    outData.graph().addNode(outNode1);
+
+    auto outNode2 = std::make_shared<NodeBase>();
+    outData.graph().addNode(outNode2);
+
+    outData.graph().addEdge(std::make_shared<EdgeBase>(*outNode2, *outNode0));
+    outData.graph().addEdge(std::make_shared<EdgeBase>(*outNode0, *outNode2));
+    outData.graph().addEdge(std::make_shared<EdgeBase>(*outNode1, *outNode0));
+    outData.graph().addEdge(std::make_shared<EdgeBase>(*outNode0, *outNode1));
+
+    // Serialize
+    const auto document = Serializer::toXml(outData);
+
+    // Edges are grouped by source node in node order and keep their insertion order
+    QStringList order;
+    const auto edges = document.elementsByTagName(Serializer::DataKeywords::Design::Graph::EDGE);
+    for (int i = 0; i < edges.count(); i++)
+    {
+        const auto edge = edges.at(i).toElement();
+        order << edge.attribute(Serializer::DataKeywords::Design::Graph::Edge::INDEX0) + "-" +
+                 edge.attribute(Serializer::DataKeywords::Design::Graph::Edge::INDEX1);
+    }
+
+    QCOMPARE(order, QStringList({"0-2", "0-1", "1-0", "2-0"}));
+}
+
 void SerializerTest::testNodeDeletion()
 {
     MindMapData outData;
@@ -103,6 +365,22 @@ void SerializerTest::testSingleEdge()
     QCOMPARE((*edges.begin())->text(), text);
 }
 
+void SerializerTest::testSingleEdge_UnknownNode()
+{
+    QByteArray bytes(
+        "<?xml version='1.0' encoding='UTF-8'?>"
+        "<design version='1.0'>"
+        "<graph>"
+        "<node index='0'/>"
+        "<edge index0='0' index1='1'/>"
+        "</graph>"
+        "</design>");
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+
+    QVERIFY(Serializer::fromXml(buffer) == nullptr);
+}
+
 void SerializerTest::testSingleNode()
 {
     MindMapData outData;
@@ -130,4 +408,205 @@ void SerializerTest::testSingleNode()
     QCOMPARE(node->text(), outNode->text());
 }
 
+void SerializerTest::testNodeAttributes()
+{
+    QByteArray bytes(
+        "<?xml version='1.0' encoding='UTF-8'?>"
+        "<design version='1.0'>"
+        "<graph>"
+        "<node foo='1' h='500' w='1500' y='-2000' x='+1000' index='3'/>"
+        "<node index=' 4 ' x='-2147483648' y='2147483647' w='100'/>"
+        "<node index='5' x='1.5' y='99999999999'/>"
+        "</graph>"
+        "</design>");
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+
+    const auto inData = Serializer::fromXml(buffer);
+    QVERIFY(inData != nullptr);
+    QCOMPARE(inData->graph().numNodes(), 3);
+
+    // Attributes can be in any order
+    QCOMPARE(inData->graph().getNode(3)->location(), QPointF(1, -2));
+    QCOMPARE(inData->graph().getNode(3)->size(), QSizeF(1.5, 0.5));
+
+    // The size is taken only if both width and height are given
+    QCOMPARE(inData->graph().getNode(4)->location(), QPointF(-2147483.648, 2147483.647));
+    QCOMPARE(inData->graph().getNode(4)->size(), NodeBase().size());
+
+    // Invalid numbers are read as zero
+    QCOMPARE(inData->graph().getNode(5)->location(), QPointF(0, 0));
+}
+
+void SerializerTest::testTablesFormat()
+{
+    MindMapData outData;
+    for (int i = 0; i < 10; i++)
+    {
+        auto node = std::make_shared<NodeBase>();
+        node->setColor(i % 2 ? QColor(1, 2, 3) : QColor(4, 5, 6));
+        node->setText(i % 3 ? "Lorem ipsum" : "");
+        node->setLocation(QPointF(i, -i));
+        outData.graph().addNode(node);
+    }
+
+    auto edge = std::make_shared<EdgeBase>(*outData.graph().getNode(0), *outData.graph().getNode(1));
+    edge->setText("Lorem ipsum");
+    outData.graph().addEdge(edge);
+    outData.graph().addEdge(std::make_shared<EdgeBase>(*outData.graph().getNode(1), *outData.graph().getNode(2)));
+
+    QBuffer inlineBuffer;
+    inlineBuffer.open(QIODevice::WriteOnly);
+    QVERIFY(Serializer::toXml(outData, inlineBuffer));
+
+    QBuffer tablesBuffer;
+    tablesBuffer.open(QIODevice::ReadWrite);
+    QVERIFY(Serializer::toXml(outData, tablesBuffer, Serializer::Format::Tables));
+
+    // Background color and both palette colors, one copy of the text
+    QCOMPARE(tablesBuffer.data().count("<color"), 3);
+    QCOMPARE(tablesBuffer.data().count("Lorem ipsum"), 1);
+    QVERIFY(tablesBuffer.data().size() < inlineBuffer.data().size());
+
+    tablesBuffer.seek(0);
+    const auto inData = Serializer::fromXml(tablesBuffer);
+    QVERIFY(inData != nullptr);
+    QCOMPARE(inData->graph().numNodes(), 10);
+    for (int i = 0; i < 10; i++)
+    {
+        const auto node = inData->graph().getNode(i);
+        QCOMPARE(node->color(), i % 2 ? QColor(1, 2, 3) : QColor(4, 5, 6));
+        QCOMPARE(node->text(), QString(i % 3 ? "Lorem ipsum" : ""));
+        QCOMPARE(node->location(), QPointF(i, -i));
+    }
+
+    QCOMPARE(inData->graph().getEdges().size(), static_cast<size_t>(2));
+    QCOMPARE(inData->graph().getEdges().at(0)->text(), QString("Lorem ipsum"));
+    QCOMPARE(inData->graph().getEdges().at(1)->text(), QString(""));
+}
+
+void SerializerTest::testTablesFormat_InvalidId()
+{
+    QByteArray bytes(
+        "<?xml version='1.0' encoding='UTF-8'?>"
+        "<design version='1.0'>"
+        "<palette><color r='1' g='2' b='3'/></palette>"
+        "<strings><text>Lorem</text></strings>"
+        "<graph>"
+        "<node index='0' c='0' t='1'/>"
+        "</graph>"
+        "</design>");
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+
+    QVERIFY(Serializer::fromXml(buffer) == nullptr);
+}
+
+void SerializerTest::testUnknownElements()
+{
+    QByteArray bytes(
+        "<?xml version='1.0' encoding='UTF-8'?>"
+        "<design version='1.0'>"
+        "<foo><node index='5'/></foo>"
+        "<graph>"
+        "<node index='0' x='1000' y='2000'><bar>baz</bar><text>Lorem</text></node>"
+        "<node index='1'/>"
+        "<edge index0='0' index1='1'><text>ipsum</text></edge>"
+        "</graph>"
+        "</design>");
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+
+    // Unknown elements are skipped as a whole
+    const auto inData = Serializer::fromXml(buffer);
+    QVERIFY(inData != nullptr);
+    QCOMPARE(inData->version(), QString("1.0"));
+    QCOMPARE(inData->graph().numNodes(), 2);
+    QCOMPARE(inData->graph().getNode(0)->location(), QPointF(1, 2));
+    QCOMPARE(inData->graph().getNode(0)->text(), QString("Lorem"));
+    QCOMPARE(inData->graph().getEdges().size(), static_cast<size_t>(1));
+    QCOMPARE(inData->graph().getEdges().at(0)->text(), QString("ipsum"));
+}
+
+void SerializerTest::testXml_ManyNodes()
+{
+    // Enough nodes to be parsed in several chunks
+    MindMapData outData;
+    for (int i = 0; i < 20000; i++)
+    {
+        auto outNode = std::make_shared<NodeBase>();
+        outNode->setLocation(QPointF(i, -i));
+        outNode->setText(i % 2 ? QString("Node %1").arg(i) : "Lorem ipsum");
+        outData.graph().addNode(outNode);
+
+        if (i)
+        {
+            auto edge = std::make_shared<EdgeBase>(*outData.graph().getNode(i - 1), *outNode);
+            edge->setText(QString::number(i));
+            outData.graph().addEdge(edge);
+        }
+    }
+
+    for (auto format : {Serializer::Format::Inline, Serializer::Format::Tables})
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(Serializer::toXml(outData, buffer, format));
+
+        // An unknown element among the nodes cannot be parsed in chunks and is skipped by the fallback
+        auto xml = buffer.data();
+        auto misplaced = xml;
+        misplaced.insert(misplaced.indexOf("<node index=\"10000\""), "<foo><node index=\"20000\"/></foo>");
+
+        for (auto && bytes : {xml, misplaced})
+        {
+            qint64 position = 0;
+            const auto inData = Serializer::fromXml(bytes, [&] (qint64 newPosition) {
+                position = newPosition;
+                return true;
+            });
+
+            QVERIFY(inData != nullptr);
+            QVERIFY(position > 0 && position <= bytes.size());
+            QCOMPARE(inData->graph().numNodes(), 20000);
+            for (int i = 0; i < 20000; i++)
+            {
+                const auto & node = inData->graph().getNodes().at(i);
+                QCOMPARE(node->index(), i);
+                QCOMPARE(node->location(), QPointF(i, -i));
+                QCOMPARE(node->text(), i % 2 ? QString("Node %1").arg(i) : QString("Lorem ipsum"));
+            }
+
+            // Edges are linked to the nodes parsed in chunks
+            QCOMPARE(inData->graph().getEdges().size(), static_cast<size_t>(19999));
+            for (int i = 1; i < 20000; i++)
+            {
+                const auto & edge = inData->graph().getEdges().at(i - 1);
+                QCOMPARE(edge->sourceNodeBase().index(), i - 1);
+                QCOMPARE(edge->targetNodeBase().index(), i);
+                QCOMPARE(edge->text(), QString::number(i));
+            }
+        }
+    }
+}
+
+void SerializerTest::testXml_ManyNodes_Canceled()
+{
+    MindMapData outData;
+    for (int i = 0; i < 20000; i++)
+    {
+        auto outNode = std::make_shared<NodeBase>();
+        outNode->setText(QString("Node %1").arg(i));
+        outData.graph().addNode(outNode);
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(Serializer::toXml(outData, buffer));
+
+    QVERIFY(Serializer::fromXml(buffer.data(), [] (qint64) {
+        return false;
+    }) == nullptr);
+}
+
 QTEST_GUILESS_MAIN(SerializerTest)
@@ -29,9 +29,41 @@ private slots:
 
     void testBackgroundColor();
 
+    void testBinaryFormat();
+
+    void testBinaryFormat_Invalid();
+
+    void testBinaryFormat_ManyNodes();
+
+    void testCompressedDesign();
+
+    void testCompressedDesign_OversizedChunk();
+
+    void testCompressedDesign_Truncated();
+
+    void testCopy();
+
+    void testCorruptedDesign();
+
+    void testEdgeOrder();
+
+    void testNodeAttributes();
+
     void testNodeDeletion();
 
     void testSingleEdge();
 
+    void testSingleEdge_UnknownNode();
+
     void testSingleNode();
+
+    void testTablesFormat();
+
+    void testTablesFormat_InvalidId();
+
+    void testUnknownElements();
+
+    void testXml_ManyNodes();
+
+    void testXml_ManyNodes_Canceled();
 };
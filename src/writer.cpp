@@ -14,20 +14,86 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "writer.hpp"
+#include "binaryserializer.hpp"
+#include "compresseddevice.hpp"
+#include "config.hpp"
+#include "serializer.hpp"
 
 #include <QFile>
-#include <QTextStream>
+#include <QSaveFile>
 
-bool Writer::writeToFile(QDomDocument document, QString filePath)
+static bool isCompressedFile(QString filePath)
 {
     QFile file(filePath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return file.open(QIODevice::ReadOnly) && CompressedDevice::hasMagic(file.peek(4));
+}
+
+template<typename XmlWriter>
+static bool writeCompressed(const XmlWriter & writeXml, QIODevice & file)
+{
+    // Compress chunk by chunk while serializing
+    CompressedDevice device(file);
+    if (!device.open(QIODevice::WriteOnly) || !writeXml(device))
     {
-        QTextStream out(&file);
-        out << document.toString();
-        file.close();
-        return true;
+        return false;
+    }
+
+    device.close();
+    return true;
+}
+
+//! Writes the file with writeXml(QIODevice &) or writeBinary(QIODevice &) depending on its format.
+template<typename XmlWriter, typename BinaryWriter>
+static bool writeFile(QString filePath, bool compress, const XmlWriter & writeXml, const BinaryWriter & writeBinary)
+{
+    const bool binary = filePath.endsWith(Config::BINARY_FILE_EXTENSION);
+    compress = !binary && (compress || isCompressedFile(filePath));
+
+    QIODevice::OpenMode mode = QIODevice::WriteOnly;
+    if (!binary && !compress)
+    {
+        mode |= QIODevice::Text;
+    }
+
+    QSaveFile file(filePath);
+    if (file.open(mode))
+    {
+        bool written = false;
+        if (binary)
+        {
+            written = writeBinary(file);
+        }
+        else if (compress)
+        {
+            written = writeCompressed(writeXml, file);
+        }
+        else
+        {
+            written = writeXml(file);
+        }
+
+        if (!written)
+        {
+            file.cancelWriting();
+        }
+
+        return file.commit();
     }
 
     return false;
 }
+
+bool Writer::writeToFile(MindMapData & mindMapData, QString filePath, bool compress, Serializer::Format format)
+{
+    // Stream from the live graph instead of taking a snapshot of it
+    return writeFile(filePath, compress,
+        [&] (QIODevice & device) { return Serializer::toXml(mindMapData, device, format); },
+        [&] (QIODevice & device) { return BinarySerializer::toBinary(mindMapData, device); });
+}
+
+bool Writer::writeToFile(const GraphSnapshot & snapshot, QColor backgroundColor, QString filePath, bool compress, Serializer::Format format)
+{
+    return writeFile(filePath, compress,
+        [&] (QIODevice & device) { return Serializer::toXml(snapshot, backgroundColor, device, format); },
+        [&] (QIODevice & device) { return BinarySerializer::toBinary(snapshot, backgroundColor, device); });
+}
@@ -16,11 +16,27 @@
 #ifndef WRITER_HPP
 #define WRITER_HPP
 
-#include <QDomDocument>
+#include <QString>
+
+#include "mindmapdata.hpp"
+#include "serializer.hpp"
+
+class GraphSnapshot;
 
 namespace Writer {
 
-    bool writeToFile(QDomDocument document, QString filePath);
+    /*! Streams the mind map to the given file. The binary format is used if the file name ends
+     *  with Config::BINARY_FILE_EXTENSION. Otherwise XML is written
+     *  in the given format and compressed with CompressedDevice if requested or if the existing file
+     *  is already compressed.
+     *  The file is replaced atomically and only if all writes succeed. The mind map itself is not
+     *  changed, but the file has its nodes numbered as after Graph::compact(). */
+    bool writeToFile(MindMapData & mindMapData, QString filePath, bool compress = false,
+        Serializer::Format format = Serializer::Format::Inline);
+
+    //! Writes the mind map from a snapshot like above. Can be called from any thread.
+    bool writeToFile(const GraphSnapshot & snapshot, QColor backgroundColor, QString filePath, bool compress = false,
+        Serializer::Format format = Serializer::Format::Inline);
 }
 
 #endif // WRITER_HPP